@@ -5,31 +5,45 @@
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>
-
-#define STATES_ARR_LEN 255
+#include <time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #define PRINT_STATS_EVERY_CHECKED
-#define PRINT_STATS_EVERY_CHECKED_N 1000000
+#define PRINT_STATS_EVERY_CHECKED_N (1 << 20)    // a power of two, checked at the time limit's checkpoints
 
+// the default (37 hole, French) board
 #define FULL_BOARD_BITS 0b0011100011111011111111111111111111101111100011100uLL
 #define FULL_BOARD_CT 37
-
-// board positions that moves can be made at;
-//   as min and max index limits (BOTH inclusive)
-//   (carves out the three unavailable positions in each corner)
-
-const int BOARD_MOVABLE_IND_LIM_MIN[] = {3,2,1,0,1,2,3};
-const int BOARD_MOVABLE_IND_LIM_MAX[] = {3,4,5,6,5,4,3};
+// the 33 hole (English) board
+#define ENGLISH_BOARD_BITS 0b0011100001110011111111111111111111100111000011100uLL
+// any board is a set of holes of the 7*7 grid
+#define MAX_BOARD_CT 49
 
 // enum for directions
+//   (the diagonal ones are only used on boards with diagonal jumps)
 
 #define LEFT 1
 #define RIGHT 2
 #define UP 3
 #define DOWN 4
+#define UP_LEFT 5
+#define UP_RIGHT 6
+#define DOWN_LEFT 7
+#define DOWN_RIGHT 8
 
-const int DIRS[] = {LEFT, RIGHT, UP, DOWN};
-const int DIRS_LEN = 4;
+const int DIRS[] = {LEFT, RIGHT, UP, DOWN, UP_LEFT, UP_RIGHT, DOWN_LEFT, DOWN_RIGHT};
+#define ORTHOGONAL_DIRS_LEN 4
+#define MAX_DIRS 8
 
 // directional offsets (ADDING to a row or column index, respectively)
 
@@ -37,11 +51,49 @@ const int DIRS_LEN = 4;
 #define RIGHT_ROW_OFFSET 0
 #define UP_ROW_OFFSET -1
 #define DOWN_ROW_OFFSET 1
+#define UP_LEFT_ROW_OFFSET -1
+#define UP_RIGHT_ROW_OFFSET -1
+#define DOWN_LEFT_ROW_OFFSET 1
+#define DOWN_RIGHT_ROW_OFFSET 1
 
 #define LEFT_COL_OFFSET -1
 #define RIGHT_COL_OFFSET 1
 #define UP_COL_OFFSET 0
 #define DOWN_COL_OFFSET 0
+#define UP_LEFT_COL_OFFSET -1
+#define UP_RIGHT_COL_OFFSET 1
+#define DOWN_LEFT_COL_OFFSET -1
+#define DOWN_RIGHT_COL_OFFSET 1
+
+// the most children a single state could ever generate (one per direction per position)
+#define MAX_CHILDREN (MAX_DIRS * MAX_BOARD_CT)
+// the state array holds the current path of the search, one state per move (and the start)
+#define STATES_ARR_LEN (MAX_BOARD_CT + 1)
+
+// enum for move ordering heuristics
+//   (how the children of a state are ranked before they are searched; the highest ranked child is searched first)
+
+#define ORDER_NONE 0
+#define ORDER_CENTER 1
+#define ORDER_MOBILITY 2
+#define ORDER_HISTORY 3
+
+// the longest possible solution chain (a full board down to one marble)
+#define MAX_CHAIN_LEN MAX_BOARD_CT
+
+// enum for search engines
+
+#define ENGINE_DFS 0
+#define ENGINE_NMCS 1
+#define ENGINE_BEAM 2
+#define ENGINE_IDA 3
+
+#define DEFAULT_NMCS_LEVEL 1
+#define DEFAULT_BEAM_WIDTH 4096
+#define DEFAULT_CACHE_MB 64
+
+// how many neighboring slots of the visited-state cache a board may be stored in
+#define CACHE_PROBE_LEN 8
 
 /* TODO: PLANS for FUTURE FLAGS:
     [(-s | --silent) [(b | d | x)][p]] only output solution(s?) in a listed minimal representation, and no debug info.
@@ -50,12 +102,19 @@ const int DIRS_LEN = 4;
                                      defaults to padding 49 bits for binary format and no padding for decimal or hex.)
                                     minimal output would be like:
                                     the best ct, followed by each state. all in a list (i.e. separated by \n)
-    [(-p | --processes) <num>] number of threads to create and run. 0 = automatic via CPU detection. default 1.
-    [-e | --exhaustive] exhaustive search for solutions that match the solution condition.
     
     allow multiple starting board states and/or multiple target board states!
 */
 
+// packed binary board-state files
+//   A fixed 32 byte header (states_file_header_t), then count states of 8 bytes each, in host byte order.
+
+#define STATES_FILE_MAGIC "SOLB"
+#define STATES_FILE_VERSION 1
+#define STATES_FILE_SORTED 1            // flag: states are strictly increasing (sorted, no duplicates)
+#define STATES_ENCODING_BITS 0          // each state is its 49 board bits
+#define STATES_ENCODING_RANK_BITMAP 1   // one bit for each arrangement of count marbles, by rank (a tablebase layer)
+
 // FLAGS_HELP array is structured like:
 // {
 //    {flags, usage, short_desc, extra_desc},
@@ -92,9 +151,158 @@ const struct _flags_help FLAGS_HELP[] = {
     {"-d", "[-d]",
         "Parse board-states in decimal instead of binary.",
         "This flag cannot be used with -x."},
+    {"-o | --order", "[(-o | --order) (none | center | mobility | history)]",
+        "Choose the heuristic used to order each state's moves before searching them.",
+        "The best ranked move of a state is searched first."
+        " none: the fixed direction, row, column order of generation."
+        " center: prefer moves that remove outlying marbles, land near the center of the board, and leave no marble isolated."
+        " mobility: prefer moves that leave the most moves available afterwards (ties broken by center)."
+        " history: center, plus a bonus for moves that took part in previously found best solutions."
+        " Default is center. The ranked orders reach a 1 marble solution from a mid-game board far more often in a time limit"
+        " than none; from a full board's start, use --engine ida."},
+    {"--engine", "[--engine (dfs | nmcs | beam | ida)]",
+        "Choose the search engine.",
+        "dfs: the exact depth first search. Finds a solution if there is one, given enough time."
+        " ida: iterative deepening on the marble count; tries to reach 1 marble, proves it impossible, then 2, and so on."
+        " It finds the minimum reachable marble count and proves it optimal,"
+        " using a lower bound on the final marble count and a cache of states already proven unable to reach a count."
+        " With a -c | --count threshold above the lower bound, it tries the threshold first, and stops at any board within it."
+        " nmcs: nested Monte Carlo search. Plays nested random games, following the best line found so far."
+        " beam: keeps only the best --width states (by a board heuristic) of each marble count, without duplicates."
+        " nmcs and beam quickly find good solutions but cannot prove that none better exists."
+        " nmcs, beam and ida solve for a marble count, so cannot be used with -t | --target."
+        " Default is dfs."},
+    {"--time-limit", "[--time-limit <seconds>]",
+        "Stop searching after a number of seconds and report the best solution found so far.",
+        "Applies to every engine. With a time limit, nmcs repeats with one more level of nesting"
+        " and beam repeats with double the width, each time the previous search finished early without reaching the threshold."
+        " Default is no time limit."},
+    {"--level", "[--level <level>]",
+        "Nesting level of the nmcs engine.",
+        "Level 0 is a single random game; each level plays every move, then the level below from there, and keeps the best."
+        " Higher levels take exponentially longer. Default is 1."},
+    {"--width", "[--width <width>]",
+        "Beam width of the beam engine.",
+        "How many states are kept at each marble count. Default is 4096."},
+    {"--split-depth", "[--split-depth <depth> [--shards <count>] --work-dir <dir>]",
+        "Plan a search to be split into shards, solved by separate processes.",
+        "Finds every distinct state reachable in <depth> moves from the starting state (and any dead end before that),"
+        " and deals them into <count> shard files in <dir>, with a plan file holding the start, solution condition and board."
+        " A depth past the solution's marble count is cut to it. Then exits; solve each shard with --shard, and combine the results with --merge."
+        " Default shard count is 1."},
+    {"--shard", "[--shard <index>/<count> --work-dir <dir>]",
+        "Search the states of one shard of a planned split, and write its result file.",
+        "The starting state and solution condition are read from the plan in <dir>, so none need to be given."
+        " The board (--board, --diagonal) must be the same as when planning."
+        " Index counts from 0. Only the dfs and ida engines can solve shards."
+        " Shards may be run in any order, at the same time, on any machine sharing <dir>."},
+    {"--merge", "[--merge --work-dir <dir>]",
+        "Combine the result files of a planned split.",
+        "Reports the best result of all the shards, its solution chain, and the total states checked and generated."
+        " Warns about any shard that has no result file yet, or did not finish searching."},
+    {"--work-dir", "[--work-dir <dir>]",
+        "Directory holding the plan, shard and result files of a split search.",
+        "Used by --split-depth, --shard and --merge. Created if it does not exist."},
+    {"--targets", "[--targets <binary-file>]",
+        "Specify a set of board states as a solution condition, read from a packed binary file.",
+        "Like -t | --target, but any state in the file is a solution. The file is memory-mapped, so huge sets load instantly."
+        " Unsorted files are sorted in memory first; convert with --to-binary --sort to skip that."
+        " Only the dfs engine can search for targets, and not in a split search."
+        " This flag cannot be used with -t | --target or -c | --count."},
+    {"--to-binary", "[--to-binary <text-file> <binary-file> [--sort]]",
+        "Convert a text file of board states, one per line, to a packed binary file. Then exit.",
+        "Board states are parsed like any other (binary by default, or with -d or -x; hex also as printed, \"0x <hex>\")."
+        " Empty lines between states separate chains, and are written as a 0 state (see --validate)."
+        " With --sort, the states are sorted and duplicates removed, which lets --targets use the file as is;"
+        " empty lines are then skipped."
+        " The binary file has a 32 byte header (magic \"SOLB\", version, flags, encoding, the board's holes and the state count),"
+        " followed by each state in 8 bytes."},
+    {"--to-text", "[--to-text <binary-file> <text-file>]",
+        "Convert a packed binary file of board states to a text file, one state per line. Then exit.",
+        "States are written in binary by default, or in decimal or hex with -d or -x, so they can be read back as board states."
+        " A 0 state (between chains) is written as an empty line."},
+    {"-p | --processes", "[(-p | --processes) <num>]",
+        "Number of threads to create and run.",
+        "0 is automatic, one per CPU (via CPU detection). Used by --tablebase, --validate, --survey, --huge-pages prefault and the analyze command of -i | --interactive. Default is 1."},
+    {"--tablebase", "[--tablebase <max-marbles> [--reach <final>] --work-dir <dir>]",
+        "Build tablebase layers of every board with 1 up to <max-marbles> marbles, then exit.",
+        "For each marble count, and each final count f from 1 to <final>, a layer is a bitmap over every arrangement"
+        " of that many marbles (by rank), with a bit set if a board with at most f marbles can be reached from it."
+        " Each layer is derived from the finished layer one marble below, split across threads (-p | --processes)."
+        " Layers are written into <dir> as packed binary files (tb_<marbles>_reach_<f>.bin),"
+        " and ones already there are reused, so an interrupted build carries on where it stopped."
+        " Default final count is 1."},
+    {"--cache-mb", "[--cache-mb <megabytes>]",
+        "Size of the visited-state cache of the ida engine.",
+        "A bigger cache remembers more states proven unable to reach a marble count,"
+        " so less of the search is repeated. Default is 64."},
+    {"-i | --interactive", "[-i | --interactive]",
+        "Play a game out by hand at a prompt, asking the ida engine for hints and analysis along the way.",
+        "Starts from the given board state, if any; type help at the prompt for the commands."
+        " The engine's cache (--cache-mb) is kept for the whole session, so the answers get quicker as a game goes on."
+        " analyze solves every move of the board in parallel, with -p | --processes threads."
+        " --time-limit applies to each command on its own."
+        " This flag cannot be used with -t | --target, --targets or a split search."},
+    {"--bench", "[--bench]",
+        "Run the kernel microbenchmarks, then exit.",
+        "Times attempt_move, next_child (taking every child), gen_children, count_moves, count_bits, canonical_bits, cache_get"
+        " and parse_board_state, each over the same fixed corpus of random legal boards (4096 boards each of 32, 24, 16 and 8 marbles),"
+        " and whole dfs searches (to 1 marble, and to a target state) from the boards of 8 marbles."
+        " cache_get is timed again on a copy of the cache on plain 4 kB pages, to show what huge pages (--huge-pages) save."
+        " Where Linux allows perf_event_open (see /proc/sys/kernel/perf_event_paranoid), also reports cycles, instructions,"
+        " branch misses and cache misses per call; otherwise, only the time."},
+    {"--board", "[--board (french | english | <mask-file>)]",
+        "Choose the board: which holes of the 7*7 grid are playable.",
+        "french: the 37 hole board (the default). english: the 33 hole cross shaped board."
+        " <mask-file>: a text file holding the board's holes as a board state (49 bits of 0 and 1, in reading order,"
+        " on one line or as 7 rows; other characters are ignored)."
+        " Every board must fit the 7*7 grid, so boards with more rows or columns (like the 41 hole board) cannot be played."
+        " Must be given before any board state, and the same for every run of a split search."},
+    {"--diagonal", "[--diagonal]",
+        "Allow jumps along the diagonals too, on whichever board is chosen.",
+        "Without the color parity bound (it does not hold for diagonal jumps), the ida engine has to search more."
+        " Tablebase layers built with diagonal jumps are kept in their own files (tb_<marbles>_reach_<f>_diagonal.bin)."},
+    {"-e | --exhaustive", "[-e | --exhaustive]",
+        "Search the whole tree, counting every solution, instead of stopping at the first.",
+        "A solution is a line of moves from the start that reaches the solution condition (a threshold or target state);"
+        " lines going on past a solution are not counted again. The first solution's chain is shown."
+        " Only the dfs engine can search exhaustively, and not in a split search."},
+    {"--validate", "[--validate <chain-file>]",
+        "Check a file of solution chains, then exit with status 1 if any chain is invalid.",
+        "A text file holds one board state per line (formatted as for -d and -x; hex also as printed, \"0x <hex>\"),"
+        " with a blank line between chains;"
+        " a packed binary file (see --to-binary) holds the chains' states with a 0 state between chains."
+        " Every step must be one legal jump on the chosen board (--board, --diagonal), every chain must end on the solution"
+        " condition (-c | --count, -t | --target or --targets; default is 1 marble), and if a starting state is given,"
+        " every chain must begin with it. The first invalid step of each invalid chain is reported with its line (or state) number."
+        " The file is split between threads (-p | --processes)."},
+    {"--huge-pages", "[--huge-pages (off | on | prefault)]",
+        "Choose how the large tables (the ida engine's cache, tablebase layers and a sorted target set) are allocated.",
+        "on: on 2 MB huge pages, explicit ones (MAP_HUGETLB) if the system has some reserved, else transparent ones (madvise),"
+        " else plain pages; the kind obtained (for transparent ones, requested) is reported. prefault: the same, and the table is touched by -p | --processes"
+        " threads as soon as it is allocated, so the search does not stop for page faults; the huge pages obtained are reported."
+        " off: plain calloc(). Default is on."},
+    {"--survey", "[--survey]",
+        "Solve every start with one marble missing, in one run, then exit.",
+        "Prints a table with a row for each start: the fewest marbles it can end with (proven, as the ida engine does),"
+        " or with -t | --target, whether it can reach the target state (such as one marble on a chosen hole)."
+        " Then a solution chain for each start ending with at most the threshold (-c | --count, default 1) or on the target,"
+        " with a blank line between chains, so they can be checked with -x --validate once their heading lines are removed."
+        " Starts that are images of one another under a symmetry of the board (that keeps the target) are solved once;"
+        " the boards after their first moves are solved by -p | --processes threads sharing one cache (--cache-mb),"
+        " so boards reached from several starts are only worked out once. --time-limit applies to the whole survey."
+        " No starting state is given with this flag."},
+    {"--profile", "[--profile <csv-file>]",
+        "Profile the search tree of the dfs or ida engine, and write it to a CSV file when the search is over.",
+        "A row (row = ct) for each marble count: states checked, expanded (given moves), the branching factor"
+        " (states checked with one marble less per state expanded), dead ends, solutions, states cut off by the marble count"
+        " (dfs, for a target), by the color parity bound and by the cache (ida), cache probes and hits (ida), and the time spent,"
+        " sampled every 4096 states. Then a row (row = root_child) for each move of the start: the board after it,"
+        " and the states checked under it (for dfs, sampled at the same checkpoints). The ida engine's counts add up over its iterations."
+        " Profiling makes a dfs search with -o none (the cheapest states) about 3% slower, and other searches 1-2% slower."},
     NULL
 };
-const int FLAGS_HELP_LEN = 5;
+const int FLAGS_HELP_LEN = 29;
 
 // FLAGS_HELP_MAP[] contains mappings between a string (which is a flag),
 // and a corresponding struct _flags_help that came from FLAGS_HELP[].
@@ -114,14 +322,46 @@ const struct _flags_help_mapping FLAGS_HELP_MAP[] = {
     {"--count", FLAGS_HELP[2]},
     {"-x", FLAGS_HELP[3]},
     {"-d", FLAGS_HELP[4]},
+    {"-o", FLAGS_HELP[5]},
+    {"--order", FLAGS_HELP[5]},
+    {"--engine", FLAGS_HELP[6]},
+    {"--time-limit", FLAGS_HELP[7]},
+    {"--level", FLAGS_HELP[8]},
+    {"--width", FLAGS_HELP[9]},
+    {"--split-depth", FLAGS_HELP[10]},
+    {"--shards", FLAGS_HELP[10]},
+    {"--shard", FLAGS_HELP[11]},
+    {"--merge", FLAGS_HELP[12]},
+    {"--work-dir", FLAGS_HELP[13]},
+    {"--targets", FLAGS_HELP[14]},
+    {"--to-binary", FLAGS_HELP[15]},
+    {"--sort", FLAGS_HELP[15]},
+    {"--to-text", FLAGS_HELP[16]},
+    {"-p", FLAGS_HELP[17]},
+    {"--processes", FLAGS_HELP[17]},
+    {"--tablebase", FLAGS_HELP[18]},
+    {"--reach", FLAGS_HELP[18]},
+    {"--cache-mb", FLAGS_HELP[19]},
+    {"-i", FLAGS_HELP[20]},
+    {"--interactive", FLAGS_HELP[20]},
+    {"--bench", FLAGS_HELP[21]},
+    {"--board", FLAGS_HELP[22]},
+    {"--diagonal", FLAGS_HELP[23]},
+    {"-e", FLAGS_HELP[24]},
+    {"--exhaustive", FLAGS_HELP[24]},
+    {"--validate", FLAGS_HELP[25]},
+    {"--huge-pages", FLAGS_HELP[26]},
+    {"--survey", FLAGS_HELP[27]},
+    {"--profile", FLAGS_HELP[28]},
     NULL
 };
-const int FLAGS_HELP_MAP_LEN = 8;
+const int FLAGS_HELP_MAP_LEN = 40;
 
 const char BOARD_STATE_DESC[] = "<board-state>\n"
                     "A board state is represented with 49 binary bits, representing the 7*7 solitaire grid."
                         " An occupied space is represented with a 1, and an empty space with a 0."
-                        " The three spaces in each corner are always expected to be 0."
+                        " The three spaces in each corner are always expected to be 0"
+                        " (on the default board; with --board, any space that is not a hole of the board)."
                         " As a board state is therefore also an integer,"
                         " it can be represented in other bases (hex or decimal).\n"
                     "The order of bits is in reading order; left to right, top to bottom. Each row is 7 bits long, and there are 7 rows.\n"
@@ -151,6 +391,27 @@ int sarrlen = 0;
 state_t *solarr = NULL;
 int solarrlen = 0;
 
+// a set of target states (sorted) from --targets, searched for like a single -t target state
+const unsigned long long *target_set = NULL;
+unsigned long long target_set_len = 0;
+
+int search_engine = ENGINE_DFS;
+double search_deadline = 0; // in now_seconds() time; 0 if there is no time limit
+bool timed_out = false;     // set by out_of_time() from any search thread, so only accessed atomically
+
+bool exhaustive_search = false;         // -e: count every solution, instead of stopping at the first
+unsigned long long solutions_found = 0;
+bool quiet_search = false;              // leave out the "Found ..." lines while searching (for the benchmarks)
+
+int move_order = ORDER_CENTER;
+// how many times each move (indexed by direction, row, column) was part of a new best solution chain
+unsigned long move_history[MAX_DIRS][7][7];
+
+// the board being played (--board): its holes, and the directions marbles can jump in
+unsigned long long board_holes = FULL_BOARD_BITS;
+int board_ct = FULL_BOARD_CT;
+int dirs_len = ORTHOGONAL_DIRS_LEN;
+
 
 
 int is_hex(char c)
@@ -220,28 +481,38 @@ static inline unsigned long long toggle_marble(const unsigned long long bits, co
 }
 
 
+// is (row, col) one of the board's holes?
+static inline int is_hole(const int row, const int col)
+{
+    return row >= 0 && row < 7 && col >= 0 && col < 7 && is_marble(board_holes, row, col);
+}
+
+static inline void dir_offsets(const int dir, int *roff, int *coff)
+{
+    switch (dir) {
+        case LEFT:  *roff = LEFT_ROW_OFFSET;  *coff = LEFT_COL_OFFSET;  break;
+        case RIGHT: *roff = RIGHT_ROW_OFFSET; *coff = RIGHT_COL_OFFSET; break;
+        case UP:    *roff = UP_ROW_OFFSET;    *coff = UP_COL_OFFSET;    break;
+        case DOWN:  *roff = DOWN_ROW_OFFSET;  *coff = DOWN_COL_OFFSET;  break;
+        case UP_LEFT:    *roff = UP_LEFT_ROW_OFFSET;    *coff = UP_LEFT_COL_OFFSET;    break;
+        case UP_RIGHT:   *roff = UP_RIGHT_ROW_OFFSET;   *coff = UP_RIGHT_COL_OFFSET;   break;
+        case DOWN_LEFT:  *roff = DOWN_LEFT_ROW_OFFSET;  *coff = DOWN_LEFT_COL_OFFSET;  break;
+        default:         *roff = DOWN_RIGHT_ROW_OFFSET; *coff = DOWN_RIGHT_COL_OFFSET; break;
+    }
+}
+
 int is_legal_move(unsigned long long bits, int row, int col, int dir)
 {
-    // dir must be legal
-    if (dir != LEFT && dir != RIGHT && dir != UP && dir != DOWN)
+    // dir must be legal (on this board)
+    if (dir < LEFT || dir > dirs_len)
         return 0;
     
     int roff, coff; // row and column offsets
-    if(dir == LEFT)  { roff = LEFT_ROW_OFFSET;  coff = LEFT_COL_OFFSET; }
-    if(dir == RIGHT) { roff = RIGHT_ROW_OFFSET; coff = RIGHT_COL_OFFSET; }
-    if(dir == UP)    { roff = UP_ROW_OFFSET;    coff = UP_COL_OFFSET; }
-    if(dir == DOWN)  { roff = DOWN_ROW_OFFSET;  coff = DOWN_COL_OFFSET; }
-
-    // check boundaries
-    // if (row < 0 || row > 6 || col < 0 || col > 6)
-    //     return 0;
-    // if ((row == 0 && roff < 0) || (row == 6 && roff > 0) || (col == 0 && coff < 0) || (col == 6 && coff > 0))
-    //     return 0;
-    if (row < BOARD_MOVABLE_IND_LIM_MIN[col] || row > BOARD_MOVABLE_IND_LIM_MAX[col] || col < BOARD_MOVABLE_IND_LIM_MIN[row] || col > BOARD_MOVABLE_IND_LIM_MAX[row])
-        return 0uLL;
-    // cannot make a perpendicular-to-boundary move on the boundary
-    if (((row == 6 || row == 0) && roff != 0) || ((col == 6 || col == 0) && coff != 0))
-        return 0uLL;
+    dir_offsets(dir, &roff, &coff);
+
+    // the marble jumping, the one jumped, and where it lands must all be holes of the board
+    if (!is_hole(row - roff, col - coff) || !is_hole(row, col) || !is_hole(row + roff, col + coff))
+        return 0;
 
     // there must be a marble to jump
     if (!is_marble(bits, row, col))
@@ -256,43 +527,134 @@ int is_legal_move(unsigned long long bits, int row, int col, int dir)
 }
 
 
+// the board after jumping over the marble at (row, col) in direction dir, or 0 if that is not a legal move.
+// (The search itself generates moves with move_mask(); this is the one move at a time version.)
 unsigned long long attempt_move(unsigned long long bits, int row, int col, int dir)
 {
-    // dir must be legal
-    if (dir != LEFT && dir != RIGHT && dir != UP && dir != DOWN)
-        return 0uLL;
-    
-    int roff, coff; // row and column offsets
-    if(dir == LEFT)  { roff = LEFT_ROW_OFFSET;  coff = LEFT_COL_OFFSET; }
-    if(dir == RIGHT) { roff = RIGHT_ROW_OFFSET; coff = RIGHT_COL_OFFSET; }
-    if(dir == UP)    { roff = UP_ROW_OFFSET;    coff = UP_COL_OFFSET; }
-    if(dir == DOWN)  { roff = DOWN_ROW_OFFSET;  coff = DOWN_COL_OFFSET; }
-
-    // check boundaries
-    // if (row < 0 || row > 6 || col < 0 || col > 6)
-    //     return 0uLL;
-    // if ((row == 0 && roff < 0) || (row == 6 && roff > 0) || (col == 0 && coff < 0) || (col == 6 && coff > 0))
-    //     return 0uLL;
-    if (row < BOARD_MOVABLE_IND_LIM_MIN[col] || row > BOARD_MOVABLE_IND_LIM_MAX[col] || col < BOARD_MOVABLE_IND_LIM_MIN[row] || col > BOARD_MOVABLE_IND_LIM_MAX[row])
-        return 0uLL;
-    // cannot make a perpendicular-to-boundary move on the boundary
-    if (((row == 6 || row == 0) && roff != 0) || ((col == 6 || col == 0) && coff != 0))
+    if (!is_legal_move(bits, row, col, dir))
         return 0uLL;
+    int roff, coff;
+    dir_offsets(dir, &roff, &coff);
+    // set target, clear behind, and clear middle
+    return set_marble(clear_marble(clear_marble(bits, row, col), row - roff, col - coff), row + roff, col + coff);
+}
 
-    // there must be a marble to jump
-    if (!is_marble(bits, row, col))
-        return 0uLL;
-    
-    // there must be a marble in the opposite direction and no marble in the target direction
-    // i.e. to jump "from" behind, "to" target
-    return (
-        (is_marble(bits, row - roff, col - coff) && !is_marble(bits, row + roff, col + coff))
-        ? (
-            // set target, clear behind, and clear middle
-            set_marble(clear_marble(clear_marble(bits, row, col), row - roff, col - coff), row + roff, col + coff)
-        )
-        : 0uLL
-    );
+
+// ===================================
+// board geometry and move tables
+//   --board picks the holes (and --diagonal adds diagonal jumps); init_geometry() then builds,
+//   for each direction, the holes a marble can be jumped over there (an edge mask: the holes on either side
+//   are on the board too), and the bit distance between neighboring holes in that direction.
+//   Every move of a board in one direction then comes out of a few shifts and ands (move_mask()),
+//   with no branches and no per-hole bounds checks, whatever the board.
+
+unsigned long long move_mids[MAX_DIRS];     // holes that can be jumped over, in each direction
+int move_span[MAX_DIRS];                    // bit distance between neighboring holes, in each direction
+int move_rshift[MAX_DIRS], move_lshift[MAX_DIRS];   // brings the "from" hole of each move onto its jumped hole
+
+void init_geometry(unsigned long long holes, bool diagonal)
+{
+    int d, r, c, roff, coff;
+    board_holes = holes;
+    board_ct = count_bits(holes);
+    dirs_len = diagonal ? MAX_DIRS : ORTHOGONAL_DIRS_LEN;
+    for (d = 0; d < MAX_DIRS; d++)
+    {
+        dir_offsets(DIRS[d], &roff, &coff);
+        // bit index falls by 7 per row and 1 per column
+        int shift = roff * 7 + coff;
+        move_span[d] = abs(shift);
+        move_rshift[d] = shift > 0 ? shift : 0;
+        move_lshift[d] = shift < 0 ? -shift : 0;
+        move_mids[d] = 0uLL;
+        for (r = 0; r < 7; r++)
+            for (c = 0; c < 7; c++)
+                if (is_hole(r - roff, c - coff) && is_hole(r, c) && is_hole(r + roff, c + coff))
+                    move_mids[d] = set_marble(move_mids[d], r, c);
+    }
+}
+
+// the jumped marbles of every move of a board in direction DIRS[d]:
+// a marble on a jumpable hole, a marble behind it, and an empty hole ahead.
+static inline unsigned long long move_mask(const unsigned long long bits, const int d)
+{
+    unsigned long long from = (bits >> move_rshift[d]) << move_lshift[d];
+    unsigned long long to = ((board_holes & ~bits) << move_rshift[d]) >> move_lshift[d];
+    return bits & move_mids[d] & from & to;
+}
+
+// the board after the move jumping over the marble mid (a single bit of move_mask()) in direction DIRS[d]
+static inline unsigned long long apply_move(const unsigned long long bits, const unsigned long long mid, const int d)
+{
+    return bits ^ (mid | (mid << move_span[d]) | (mid >> move_span[d]));
+}
+
+// the highest bit of a (nonzero) move mask; taking those first keeps the row, then column, order of attempt_move() loops
+static inline unsigned long long highest_bit(const unsigned long long mask)
+{
+    return 1uLL << (63 - __builtin_clzll(mask));
+}
+
+
+// marbles with no orthogonally adjacent marble
+int count_isolated(unsigned long long bits)
+{
+    const unsigned long long NOT_COL0 = 0b0111111011111101111110111111011111101111110111111uLL;
+    const unsigned long long NOT_COL6 = NOT_COL0 << 1;
+    unsigned long long nb = ((bits & NOT_COL0) << 1) | ((bits & NOT_COL6) >> 1) | (bits << 7) | (bits >> 7);
+    return __builtin_popcountll(bits & ~nb);
+}
+
+static inline int center_dist(const int row, const int col)
+{
+    return abs(row - 3) + abs(col - 3);
+}
+
+int count_moves(unsigned long long bits)
+{
+    int d;
+    int moves = 0;
+    for (d = 0; d < dirs_len; d++)
+        moves += __builtin_popcountll(move_mask(bits, d));
+    return moves;
+}
+
+// ranks a move by the move ordering heuristic; higher is searched sooner.
+// (row, col) is the jumped marble, like attempt_move(), and newbits the board after the move.
+long score_move(unsigned long long newbits, int row, int col, int dir)
+{
+    int roff, coff;
+    dir_offsets(dir, &roff, &coff);
+    // the move removes the marbles at "from" and "over", and puts one at "to".
+    // Marbles left far from the center are the ones likely to be stranded later.
+    long center = center_dist(row - roff, col - coff) + center_dist(row, col) - center_dist(row + roff, col + coff);
+    // and a marble with no neighbors can only be rescued by another marble coming to it.
+    center -= 8L * count_isolated(newbits);
+    switch (move_order) {
+        case ORDER_CENTER:
+            return center;
+        case ORDER_MOBILITY:
+            return (long) count_moves(newbits) * 32 + center;
+        case ORDER_HISTORY:
+            return (long) move_history[dir-1][row][col] * 32 + center;
+        default:
+            return 0;
+    }
+}
+
+// credit every move of the saved solution chain, for the history move ordering heuristic
+void record_history()
+{
+    int i, r, c, d;
+    for (i = 1; i < solarrlen; i++)
+    {
+        unsigned long long frombits = solarr[i-1].bits, tobits = solarr[i].bits;
+        for (d = 0; d < dirs_len; d++)
+            for (r = 0; r < 7; r++)
+                for (c = 0; c < 7; c++)
+                    if (attempt_move(frombits, r, c, DIRS[d]) == tobits)
+                        move_history[DIRS[d]-1][r][c]++;
+    }
 }
 
 
@@ -351,56 +713,89 @@ void print_solarr()
 }
 
 
-int add_all_moves_latest()
-{
-    // printf("sarrlen == %d\n", sarrlen);
-    int curindex = sarrlen - 1; // the end of the array
-    state_t *curstate = &sarr[curindex]; // by reference, for assignment to ->visited
-    // handle removal
-    if (curstate->visited)
-    {
-        // if marked as visited, that means it has been visited already by this Depth First search.
-        sarrlen--; // "remove" from array
-        return -1;
-    }
-    // if not marked as visited, then "visit" it and proceed to add its children to the array.
-    curstate->visited = true;
-    // sarr[curindex] = curstate; // if not using reference (& and ->), this is needed to save the assignment of .visited
+// the moves of each state on the search path, taken one at a time as the search comes back to the state.
+// With no ordering, a state's moves are read straight off its move masks, so a child only exists once it is searched;
+// the ranked orders need every child scored first; each state's ranked children (best last) sit in ranked_children
+// just above its parent's, so the children of the whole path stay together.
+typedef struct {
+    unsigned long long mids;    // moves of direction d not taken yet, by the marble they jump
+    int d;                      // the direction being taken (from the last one down); dirs_len before the first move
+    int base, left;             // ranked orders: where its children start, and how many are not taken yet (-1 before ranking)
+} move_iter_t;
 
-    unsigned long long curbits, newbits;
-    curbits = curstate->bits;
+move_iter_t move_iters[STATES_ARR_LEN];
+unsigned long long ranked_children[STATES_ARR_LEN * MAX_CHILDREN];
 
-    // loop through all move positions, and test for moving in each direction
-    int r, c, d;
+// writes every child of a board into children, ranked by move_order (lowest score first); returns how many there are
+static inline int rank_children(unsigned long long bits, unsigned long long *children)
+{
+    // take every move in each direction, from the move mask of the board (row, then column order)
+    int d;
     int added = 0;
-    for (d = 0; d < DIRS_LEN; d++)
+    long scores[MAX_CHILDREN];
+    for (d = 0; d < dirs_len; d++)
     {
-        int dir = DIRS[d];
-        // all positions
-        for (r = 0; r < 7; r++)
+        unsigned long long mids = move_mask(bits, d);
+        while (mids)
         {
-            for (c = 0; c < 7; c++)
+            unsigned long long mid = highest_bit(mids);
+            mids ^= mid;
+            unsigned long long newbits = apply_move(bits, mid, d);
+            // insert it among the children ranked so far (lowest score first).
+            // Ties stay in generation order, so ORDER_NONE would be the plain generation order.
+            int hole = 63 - __builtin_clzll(mid);
+            long score = score_move(newbits, (48 - hole) / 7, (48 - hole) % 7, DIRS[d]);
+            int i;
+            for (i = added; i > 0 && scores[i-1] > score; i--)
             {
-                // if move cannot be performed, result is 0
-                newbits = attempt_move(curbits, r, c, dir);
-                if (newbits)
-                {
-                    // if move succeeded, "append" new state onto the end of the array
-                    sarr[sarrlen] = (state_t){
-                        .bits = newbits,
-                        .ct = curstate->ct - 1,
-                        .pindex = curindex,
-                        .visited = false
-                    };
-                    sarrlen++;
-                    added++;
-                }
+                children[i] = children[i-1];
+                scores[i] = scores[i-1];
             }
+            children[i] = newbits;
+            scores[i] = score;
+            added++;
         }
     }
     return added;
 }
 
+// readies the moves of the state at sarr[index], none of them taken
+static inline void start_moves(const int index)
+{
+    move_iters[index] = (move_iter_t){ .mids = 0, .d = dirs_len, .base = 0, .left = -1 };
+}
+
+// the next child of the state at sarr[index] to search (the best ranked first), or 0 once there are none left.
+// Children generated are added to *generated.
+static inline unsigned long long next_child(const int index, unsigned long long *generated)
+{
+    move_iter_t *it = &move_iters[index];
+    unsigned long long bits = sarr[index].bits;
+    if (move_order != ORDER_NONE)
+    {
+        if (it->left < 0)
+        {
+            // above the parent's children (the ones it has left to take, as its own taken ones are done with)
+            it->base = index > 0 ? move_iters[index-1].base + move_iters[index-1].left : 0;
+            it->left = rank_children(bits, ranked_children + it->base);
+            *generated += it->left;
+        }
+        return it->left > 0 ? ranked_children[it->base + --it->left] : 0;
+    }
+    // the same order as ranking with no scores: the last generated first, so directions backwards, lowest marble first
+    while (!it->mids)
+    {
+        if (it->d == 0)
+            return 0;
+        it->d--;
+        it->mids = move_mask(bits, it->d);
+    }
+    unsigned long long mid = it->mids & -it->mids;
+    it->mids ^= mid;
+    (*generated)++;
+    return apply_move(bits, mid, it->d);
+}
+
 
 void save_parent_chain(int index)
 {
@@ -430,137 +825,3501 @@ void save_parent_chain(int index)
 }
 
 
-unsigned long long _board_size_cap = FULL_BOARD_BITS;// (1uLL << 49);
-unsigned long long parse_board_state(char *arg, bool parse_dec, bool parse_hex)
+void save_bits_chain(const unsigned long long *chain, int chainlen)
 {
-    // will not accept both parsing options as true
-    assert(!(parse_dec && parse_hex));
-    // parse the char *arg into a number, either binary, dec, or hex
-    unsigned long long result;
-    int arglen = strlen(arg);
-    // if hex and it starts with '0x', or binary and it starts with '0b', skip past the 0x or 0b prefix.
-    if (arglen >= 2 && arg[0]=='0'
-        && ((parse_hex && arg[1]=='x') || (!parse_dec && !parse_hex && arg[1]=='b')))
+    free(solarr);
+    solarr = (state_t*) malloc(sizeof *solarr * chainlen);
+    int i;
+    for (i = 0; i < chainlen; i++)
     {
-        // skip forward 2 chars
-        arg = arg+2;
-        arglen -= 2;
+        solarr[i] = (state_t){
+            .bits = chain[i],
+            .ct = count_bits(chain[i]),
+            .pindex = i - 1,
+            .visited = false
+        };
     }
-    // check own stricter formatting
-    int i;
-    for (i = 0; i < arglen; i++)
+    solarrlen = chainlen;
+}
+
+
+double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// true once the time limit (if there is one) has run out
+bool out_of_time()
+{
+    if (__atomic_load_n(&timed_out, __ATOMIC_RELAXED))
+        return true;
+    if (search_deadline > 0 && now_seconds() >= search_deadline)
     {
-        if (parse_dec)
-        {
-            // decimal
-            if(!(arg[i] >= '0' && arg[i] <= '9'))
-                break;
-        }
-        else if (parse_hex)
-        {
-            // hex
-            if(!is_hex(arg[i]))
-                break;
-        }
-        else
-        {
-            // binary
-            if(arg[i] != '0' && arg[i] != '1')
-                break;
-        }
+        __atomic_store_n(&timed_out, true, __ATOMIC_RELAXED);
+        return true;
     }
+    return false;
+}
 
-    // parse it into a number (if stricter formatting passed)
-    if (i >= arglen) // stricter formatting passed; because for-loop completed.
+
+// writes every child of a board state into children; returns how many there are.
+// Same moves, in the same order, as rank_children() generates them (before ordering).
+int gen_children(unsigned long long bits, unsigned long long *children)
+{
+    int d;
+    int n = 0;
+    for (d = 0; d < dirs_len; d++)
     {
-        result = strtoull(arg, NULL, parse_dec ? 10 : parse_hex ? 16 : 2);
-        if(errno == ERANGE)
+        unsigned long long mids = move_mask(bits, d);
+        while (mids)
         {
-            perror("parse_board_state() failed");
-            errno = 0;
-            result = 0;
+            unsigned long long mid = highest_bit(mids);
+            mids ^= mid;
+            children[n++] = apply_move(bits, mid, d);
         }
     }
-    else // stricter formatting did not pass
-        result = 0;
-    
-    // if result == 0, presume boardstate was invalid or an error occured.
-    if (result == 0) // failed to parse successfully
+    return n;
+}
+
+// heuristic quality of a board on its own (higher is better), for the approximate engines.
+// Marbles should stay central and together, and keep moves available.
+long evaluate_board(unsigned long long bits)
+{
+    long score = 0;
+    int r, c;
+    for (r = 0; r < 7; r++)
+        for (c = 0; c < 7; c++)
+            if (is_marble(bits, r, c))
+                score -= center_dist(r, c);
+    return score - 8L * count_isolated(bits) + 2L * count_moves(bits);
+}
+
+
+// cheaper than evaluate_board(): marbles should stay central and together (higher is better)
+long board_compactness(unsigned long long bits)
+{
+    static unsigned long long rings[13];
+    static bool rings_ready = false;
+    int r, c, k;
+    if (!rings_ready)
     {
-        fprintf(stderr, "Invalid board state representation \"%s\"; when parsing in %s.\n",
-                arg, parse_dec ? "decimal [-d]" : parse_hex ? "hex [-x]" : "binary");
-        exit(1);
+        for (r = 0; r < 7; r++)
+            for (c = 0; c < 7; c++)
+                rings[center_dist(r, c)] = set_marble(rings[center_dist(r, c)], r, c);
+        rings_ready = true;
     }
-    // Otherwise, check the corners are empty and it has no extra bits anywhere
-    // using FULL_BOARD_BITS as a mask
-    if (result != (result & FULL_BOARD_BITS)) {
-        fprintf(stderr, "Invalid board state representation \"%s\"; when parsing in %s.\n"
-                "\tExcessive bits found in corners or to the left.\n",
-                arg, parse_dec ? "decimal [-d]" : parse_hex ? "hex [-x]" : "binary");
-        exit(1);
+    long score = 0;
+    for (k = 1; k <= 6; k++)
+        score -= (long) k * __builtin_popcountll(bits & rings[k]);
+    return score - 8L * count_isolated(bits);
+}
+
+
+unsigned long long rng_state = 0x9E3779B97F4A7C15uLL;
+
+// xorshift64*; deterministic, so runs are reproducible
+static inline unsigned long long rng_next()
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DuLL;
+}
+
+
+bool in_target_set(unsigned long long bits)
+{
+    unsigned long long lo = 0, hi = target_set_len;
+    while (lo < hi)
+    {
+        unsigned long long mid = lo + (hi - lo) / 2;
+        if (target_set[mid] < bits)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    return result;
+    return lo < target_set_len && target_set[lo] == bits;
 }
 
-int parse_int(char *arg)
+static inline bool is_target_state(const unsigned long long target_bits, const unsigned long long bits)
+{
+    return bits == target_bits || (target_set && in_target_set(bits));
+}
+
+// ===================================
+// search profile
+//   --profile counts, for each marble count, where the dfs or ida search spends its tree: states checked,
+//   dead ends, solutions, and states cut off (by the marble count, the color parity bound or the cache),
+//   and the number of states under each move of the start. Time is sampled at the search's checkpoints
+//   (every 4096 states) and put down to the marble count being checked then; the dfs search samples the states
+//   under the moves of the start there too (to within 4096 states of the count). The dfs search keeps its counts
+//   by depth in local arrays, adding to one as each state is dropped, and the ida search only counts what it
+//   cannot work out afterwards (cache probes are the states left once the bound has cut some off);
+//   the table is written as CSV once the search is over.
+
+typedef struct {
+    unsigned long long nodes[MAX_BOARD_CT + 1];         // states checked, by marble count
+    unsigned long long dead_ends[MAX_BOARD_CT + 1];     // states without a move
+    unsigned long long solutions[MAX_BOARD_CT + 1];     // states meeting the solution condition (or the ida bound)
+    unsigned long long count_prunes[MAX_BOARD_CT + 1];  // cut off by their marble count (dfs, solving for a target)
+    unsigned long long bound_prunes[MAX_BOARD_CT + 1];  // cut off by the color parity bound (ida)
+    unsigned long long cache_hits[MAX_BOARD_CT + 1];    // (ida) cache probes finding the state, without cutting it off
+    unsigned long long cache_prunes[MAX_BOARD_CT + 1];  // probes finding the state, and cutting it off
+    double seconds[MAX_BOARD_CT + 1];
+    double last_sample;
+    unsigned long long root_children[MAX_CHILDREN];     // each move of the start (the board after it)
+    unsigned long long root_nodes[MAX_CHILDREN];        // states checked under it, itself included
+    int root_childct;
+} profile_t;
+
+bool profiling = false;
+profile_t profile;
+
+void profile_start()
+{
+    memset(&profile, 0, sizeof profile);
+    profile.last_sample = now_seconds();
+}
+
+// puts the time since the last sample down to the marble count being checked now
+static inline void profile_sample(const int ct)
+{
+    double now = now_seconds();
+    profile.seconds[ct] += now - profile.last_sample;
+    profile.last_sample = now;
+}
+
+// adds nodes to the count of states under a move of the start
+void profile_root_child(unsigned long long bits, unsigned long long nodes)
 {
-    bool problem = false;
-    int result;
-    // check own stricter formatting
-    int arglen = strlen(arg);
     int i;
-    for (i = 0; i < arglen; i++)
+    for (i = 0; i < profile.root_childct && profile.root_children[i] != bits; i++)
+        ;
+    if (i == profile.root_childct)
     {
-        // decimal
-        if(!(arg[i] >= '0' && arg[i] <= '9') && arg[i] != '-' && arg[i] != '+')
-            break;
+        if (i == MAX_CHILDREN)
+            return;
+        profile.root_children[profile.root_childct++] = bits;
     }
-    // parse it into a number (if stricter formatting passed)
-    if (i >= arglen) // stricter formatting passed; because for-loop completed.
+    profile.root_nodes[i] += nodes;
+}
+
+// writes the profile as CSV: a "ct" row for each marble count (most marbles first), then a "root_child" row for each move of the start
+void write_profile(const char *path, int startct)
+{
+    FILE *f = fopen(path, "w");
+    int ct, i;
+    if (!f)
     {
-        result = (int) strtol(arg, NULL, 10);
-        if(errno == ERANGE)
-        {
-            perror("parse_int() failed");
-            errno = 0;
-            problem = true;
-        }
+        fprintf(stderr, "Could not write the profile \"%s\": %s\n", path, strerror(errno));
+        exit(1);
     }
-    else // stricter formatting did not pass
-        problem = true;
-    
-    // if result == 0, presume int was invalid or an error occured.
-    if (problem) // failed to parse successfully
+    fputs("row,ct,nodes,expanded,branching,dead_ends,solutions,count_prunes,bound_prunes,"
+          "cache_probes,cache_hits,cache_prunes,seconds,board\n", f);
+    for (ct = startct; ct >= 1; ct--)
     {
-        fprintf(stderr, "Invalid number \"%s\".\n",
-                arg);
+        unsigned long long expanded = profile.nodes[ct] - profile.dead_ends[ct] - profile.solutions[ct]
+                                      - profile.count_prunes[ct] - profile.bound_prunes[ct] - profile.cache_prunes[ct];
+        unsigned long long probes = search_engine == ENGINE_IDA
+                                    ? profile.nodes[ct] - profile.solutions[ct] - profile.bound_prunes[ct] : 0;
+        if (!profile.nodes[ct])
+            continue;
+        // (every state checked with one marble less was reached from an expanded state of this count)
+        fprintf(f, "ct,%d,%llu,%llu,%.3f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.6f,\n", ct, profile.nodes[ct], expanded,
+                expanded ? (double) profile.nodes[ct-1] / expanded : 0.0, profile.dead_ends[ct], profile.solutions[ct],
+                profile.count_prunes[ct], profile.bound_prunes[ct], probes, profile.cache_hits[ct] + profile.cache_prunes[ct],
+                profile.cache_prunes[ct], profile.seconds[ct]);
+    }
+    for (i = 0; i < profile.root_childct; i++)
+        fprintf(f, "root_child,%d,%llu,,,,,,,,,,,%012llx\n", startct - 1, profile.root_nodes[i], profile.root_children[i]);
+    if (fclose(f) != 0)
+    {
+        fprintf(stderr, "Could not write the profile \"%s\": %s\n", path, strerror(errno));
         exit(1);
     }
-    return result;
+    printf("Wrote the search profile (%d marble counts, %d moves of the start) to \"%s\".\n",
+           startct, profile.root_childct, path);
 }
 
 
+// search loop modes (bits or'd together). Each combination is its own copy of dfs_loop(),
+// with the mode a constant, so the checks of the other modes compile away; solve_dfs() picks one copy up front.
+// (Profiled threshold and target searches have copies of their own; profiled exhaustive ones share one.)
+#define DFS_TARGET 1        // solving for a target state (or set) instead of a marble count threshold
+#define DFS_EXHAUSTIVE 2    // counting every solution instead of stopping at the first
+#define DFS_PROFILE 4       // counting into the profile as it goes
 
-int main(int argc, char **argv)
+// the time limit (and stats) are looked at once every this many + 1 checked states
+#define DFS_CHECKPOINT_MASK 0xFFF
+
+static inline __attribute__((always_inline))
+int dfs_loop(const int mode, unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
 {
-    // printf("Hello world\n");
-    
-    // ================================
-    // perform argument parsing
-    unsigned long long arg_start_bits = 0uLL, arg_target_bits = 0uLL;
-    bool arg_parse_boardstate_hex = false, arg_parse_boardstate_decimal = false;
-    int arg_target_count = 0;
+    int bestct = sarr[sarrlen-1].ct;
+    int largestsarrlen = sarrlen;
+    int curindex = sarrlen - 1;
+    const int rootindex = curindex;
+    // (profile) counts by sarr index, kept here and only put down to their marble counts once the search stops.
+    // Each state is counted once, as it is dropped: pdone if it was done with as soon as it was checked
+    // (dead ends, cut off states, solutions), else pexpanded.
+    unsigned long long pdone[STATES_ARR_LEN], pexpanded[STATES_ARR_LEN], psolutions[STATES_ARR_LEN], pcount_prunes[STATES_ARR_LEN];
+    if (mode & DFS_PROFILE)
     {
-        bool flags_encountered = false;
-        bool target_bits_encountered = false;
-        int i;
-        char *arg;
-        int argstrlen;
-        for (i = 1; i < argc; i++)
+        memset(pdone, 0, sizeof pdone);
+        memset(pexpanded, 0, sizeof pexpanded);
+        memset(psolutions, 0, sizeof psolutions);
+        memset(pcount_prunes, 0, sizeof pcount_prunes);
+    }
+    start_moves(curindex);
+    for (;;)
+    {
+        // inspect, or check, the latest board state: the start, then each child as the search reaches it.
+        state_t curstate = sarr[curindex];
+        (*checked)++;
+        if ((*checked & DFS_CHECKPOINT_MASK) == 0)
         {
-            arg = argv[i];
-            argstrlen = strlen(arg);
-            // printf("debug: argument received: \"%s\"\n", arg);
+            if (mode & DFS_PROFILE)
+            {
+                profile_sample(curstate.ct);
+                // the states since the last checkpoint are put down to the move of the start being searched
+                if (curindex > rootindex)
+                    profile_root_child(sarr[rootindex+1].bits, DFS_CHECKPOINT_MASK + 1);
+            }
+            if (out_of_time())
+                break;
+            #ifdef PRINT_STATS_EVERY_CHECKED
+            if ((*checked & (PRINT_STATS_EVERY_CHECKED_N - 1)) == 0)
+            {
+                printf("...info: Checked %llu states, Generated %llu states; best %d, max sarrlen %d of %d",
+                    *checked, *generated, bestct, largestsarrlen, STATES_ARR_LEN);
+                if (mode & DFS_EXHAUSTIVE)
+                    printf("; %llu solutions", solutions_found);
+                printf("...\n");
+            }
+            #endif
+        }
+
+        // check if the newly generated board state is a specific state we are looking for.
+        if (mode & DFS_TARGET)
+        {
+            // Note: this is separated from bestct logic to prevent the bestct > targetct condition stopping the while-loop.
+
+            if (is_target_state(target_bits, curstate.bits))
+            {
+                if (mode & DFS_PROFILE)
+                    psolutions[curindex]++;
+                if (!solutions_found++)
+                {
+                    if (!quiet_search)
+                        printf("Found a target state with %d marbles remaining (state base16: 0x %012llx).\n", curstate.ct, curstate.bits);
+                    save_parent_chain(curindex);
+                }
+                bestct = targetct;
+                // (nothing below a target state is counted as another solution)
+                if (mode & DFS_EXHAUSTIVE)
+                    sarr[curindex].visited = true;
+            }
+            // PRUNE depth first search by easy marble count guarantee
+            else if (curstate.ct <= targetct)
+            {
+                // curstate is not the solution,
+                // and also is easily guaranteed to never produce the solution later.
+                //   (by its marble count not being higher)
+                // Therefore, mark it for "removal".
+                // This prunes the searching needed to be performed.
+                sarr[curindex].visited = true;
+                if (mode & DFS_PROFILE)
+                    pcount_prunes[curindex]++;
+            }
+        }
+        // check if the newly generated board state is better than our best so far.
+        // (only if we are not looking for a specific board state)
+        else
+        {
+            if (curstate.ct < bestct)
+            {
+                bestct = curstate.ct;
+                if (!quiet_search)
+                    printf("Found new best state with %d marbles remaining (base16: 0x %012llx).\n", bestct, curstate.bits);
+                // save chain of solutions
+                save_parent_chain(curindex);
+                if (move_order == ORDER_HISTORY)
+                    record_history();
+            }
+            if ((mode & DFS_PROFILE) && curstate.ct <= targetct)
+                psolutions[curindex]++;
+            if ((mode & DFS_EXHAUSTIVE) && curstate.ct <= targetct)
+            {
+                // a solution; the lines going on from it are the same solution, not new ones
+                solutions_found++;
+                sarr[curindex].visited = true;
+            }
+        }
+        if (!((mode & DFS_EXHAUSTIVE) || bestct > targetct))
+            break;
+
+        // go on to the next move of the deepest state that has one left, dropping the states that are done.
+        // A state marked as visited was pruned (or is a solution), and its moves are never taken.
+        // (The state just checked is the deepest; if it is done with already, it was cut off or had no move.)
+        unsigned long long child = 0;
+        if (sarr[curindex].visited || !(child = next_child(curindex, generated)))
+        {
+            if (mode & DFS_PROFILE)
+                pdone[curindex]++;
+            sarrlen--;
+            while (sarrlen > 0 && (sarr[sarrlen-1].visited || !(child = next_child(sarrlen - 1, generated))))
+            {
+                if (mode & DFS_PROFILE)
+                    pexpanded[sarrlen-1]++;
+                sarrlen--;
+            }
+        }
+        if (sarrlen <= 0)
+            // the search is exhausted
+            break;
+        curindex = sarrlen++;
+        if (sarrlen > largestsarrlen) largestsarrlen = sarrlen;
+        sarr[curindex] = (state_t){
+            .bits = child,
+            .ct = sarr[curindex-1].ct - 1,
+            .pindex = curindex - 1,
+            .visited = false
+        };
+        start_moves(curindex);
+    }
+    if (mode & DFS_PROFILE)
+    {
+        // the states still on the stack were being searched when it stopped, except a solution it stopped at
+        int i, top = sarrlen;
+        if (top > 0 && !(mode & DFS_EXHAUSTIVE) && bestct <= targetct)
+            pdone[--top]++;
+        for (i = rootindex; i < top; i++)
+            pexpanded[i]++;
+        for (i = rootindex; i < largestsarrlen; i++)
+        {
+            int ct = sarr[rootindex].ct - (i - rootindex);
+            profile.nodes[ct] += pdone[i] + pexpanded[i];
+            profile.dead_ends[ct] += pdone[i] - psolutions[i] - pcount_prunes[i];
+            profile.solutions[ct] += psolutions[i];
+            profile.count_prunes[ct] += pcount_prunes[i];
+        }
+    }
+    return bestct;
+}
+
+int solve_dfs_threshold(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    return dfs_loop(0, target_bits, targetct, checked, generated);
+}
+
+int solve_dfs_target(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    return dfs_loop(DFS_TARGET, target_bits, targetct, checked, generated);
+}
+
+int solve_dfs_exhaustive(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    return dfs_loop(DFS_EXHAUSTIVE, target_bits, targetct, checked, generated);
+}
+
+int solve_dfs_exhaustive_target(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    return dfs_loop(DFS_TARGET | DFS_EXHAUSTIVE, target_bits, targetct, checked, generated);
+}
+
+int solve_dfs_profile_threshold(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    return dfs_loop(DFS_PROFILE, target_bits, targetct, checked, generated);
+}
+
+int solve_dfs_profile_target(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    return dfs_loop(DFS_TARGET | DFS_PROFILE, target_bits, targetct, checked, generated);
+}
+
+// the exhaustive modes are rarely profiled, so they share one copy that checks the mode as it goes
+int solve_dfs_profile(int mode, unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    if (mode == 0)
+        return solve_dfs_profile_threshold(target_bits, targetct, checked, generated);
+    if (mode == DFS_TARGET)
+        return solve_dfs_profile_target(target_bits, targetct, checked, generated);
+    return dfs_loop(mode | DFS_PROFILE, target_bits, targetct, checked, generated);
+}
+
+// the exact depth first search, from the state(s) already in sarr.
+// Returns the best marble count found, and saves its chain into solarr.
+// With exhaustive_search, keeps going to the end, counting every solution into solutions_found.
+int solve_dfs(unsigned long long target_bits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    solutions_found = 0;
+    if (profiling)
+        return solve_dfs_profile((target_bits || target_set ? DFS_TARGET : 0) | (exhaustive_search ? DFS_EXHAUSTIVE : 0),
+                                 target_bits, targetct, checked, generated);
+    if (target_bits || target_set)
+        return exhaustive_search
+            ? solve_dfs_exhaustive_target(target_bits, targetct, checked, generated)
+            : solve_dfs_target(target_bits, targetct, checked, generated);
+    return exhaustive_search
+        ? solve_dfs_exhaustive(target_bits, targetct, checked, generated)
+        : solve_dfs_threshold(target_bits, targetct, checked, generated);
+}
+
+
+// ===================================
+// nested Monte Carlo search engine
+//   A chain is the line of board states played so far, chain[0] being the starting state.
+//   Every move removes one marble, so the longer the chain the fewer marbles remain.
+
+int nmcs_goal_len; // chain length that reaches the marble threshold
+
+// plays random moves from the end of the chain until none remain; returns the new chain length
+int nmcs_playout(unsigned long long *chain, int len, unsigned long long *checked, unsigned long long *generated)
+{
+    unsigned long long children[MAX_CHILDREN];
+    int n;
+    while ((n = gen_children(chain[len-1], children)) > 0)
+    {
+        (*checked)++;
+        *generated += n;
+        chain[len] = children[rng_next() % n];
+        len++;
+    }
+    (*checked)++;
+    return len;
+}
+
+// at each state along the chain, tries every move followed by a search of the level below,
+// then plays the first move of the best line found so far. Returns the length of the best chain,
+// which is written back into chain.
+int nmcs_level(int level, unsigned long long *chain, int len, unsigned long long *checked, unsigned long long *generated)
+{
+    if (level <= 0)
+        return nmcs_playout(chain, len, checked, generated);
+
+    unsigned long long best[MAX_CHAIN_LEN], trial[MAX_CHAIN_LEN];
+    unsigned long long children[MAX_CHILDREN];
+    int bestlen = len;
+    int n, i;
+    memcpy(best, chain, sizeof *chain * len);
+    while (bestlen < nmcs_goal_len && !out_of_time() && (n = gen_children(chain[len-1], children)) > 0)
+    {
+        *generated += n;
+        for (i = 0; i < n; i++)
+        {
+            memcpy(trial, chain, sizeof *chain * len);
+            trial[len] = children[i];
+            int triallen = nmcs_level(level - 1, trial, len + 1, checked, generated);
+            if (triallen > bestlen)
+            {
+                bestlen = triallen;
+                memcpy(best, trial, sizeof *trial * triallen);
+            }
+            if (bestlen >= nmcs_goal_len || out_of_time())
+                break;
+        }
+        // follow the best line one move further
+        chain[len] = best[len];
+        len++;
+    }
+    memcpy(chain, best, sizeof *best * bestlen);
+    return bestlen;
+}
+
+// returns the best marble count found, and saves its chain into solarr
+int solve_nmcs(unsigned long long startbits, int targetct, int level, unsigned long long *checked, unsigned long long *generated)
+{
+    unsigned long long chain[MAX_CHAIN_LEN];
+    int startct = count_bits(startbits);
+    int bestct = startct;
+    nmcs_goal_len = startct - targetct + 1;
+    for (;; level++)
+    {
+        chain[0] = startbits;
+        int len = nmcs_level(level, chain, 1, checked, generated);
+        int ct = count_bits(chain[len-1]);
+        if (ct < bestct)
+        {
+            bestct = ct;
+            printf("Found new best state with %d marbles remaining (base16: 0x %012llx) at nmcs level %d.\n",
+                   bestct, chain[len-1], level);
+            save_bits_chain(chain, len);
+        }
+        // without a time limit, search the requested level only
+        if (bestct <= targetct || search_deadline <= 0 || out_of_time())
+            break;
+    }
+    return bestct;
+}
+
+
+// ===================================
+// beam search engine
+//   Every move removes one marble, so each step of the search is one marble count.
+//   Only the best (by evaluate_board()) width distinct states of each step are kept.
+
+typedef struct {
+    unsigned long long bits;
+    long score;
+    int pindex;                 // index of parent state in the previous step
+} beam_entry_t;
+
+// best score first; equal boards (which have equal scores) end up adjacent, for removing duplicates
+int beam_entry_cmp(const void *a, const void *b)
+{
+    const beam_entry_t *ea = a, *eb = b;
+    if (ea->score != eb->score)
+        return ea->score > eb->score ? -1 : 1;
+    if (ea->bits != eb->bits)
+        return ea->bits < eb->bits ? -1 : 1;
+    return 0;
+}
+
+// one beam search of the given width; returns the best marble count found, saving its chain into solarr
+int beam_search(unsigned long long startbits, int targetct, int width, unsigned long long *checked, unsigned long long *generated)
+{
+    beam_entry_t *steps[MAX_CHAIN_LEN];
+    int steplens[MAX_CHAIN_LEN];
+    beam_entry_t *candidates = (beam_entry_t*) malloc(sizeof *candidates * width * MAX_CHILDREN);
+    unsigned long long children[MAX_CHILDREN];
+    int step = 0;
+    int i, j, n;
+
+    steps[0] = (beam_entry_t*) malloc(sizeof *steps[0]);
+    steps[0][0] = (beam_entry_t){ .bits = startbits, .score = 0, .pindex = -1 };
+    steplens[0] = 1;
+    while (count_bits(startbits) - step > targetct && !out_of_time())
+    {
+        // expand every state of this step
+        int candlen = 0;
+        for (i = 0; i < steplens[step]; i++)
+        {
+            n = gen_children(steps[step][i].bits, children);
+            (*checked)++;
+            *generated += n;
+            for (j = 0; j < n; j++)
+                candidates[candlen++] = (beam_entry_t){ .bits = children[j], .score = evaluate_board(children[j]), .pindex = i };
+        }
+        if (candlen == 0)
+            break;
+        // keep the best width distinct children as the next step
+        qsort(candidates, candlen, sizeof *candidates, beam_entry_cmp);
+        step++;
+        steps[step] = (beam_entry_t*) malloc(sizeof *steps[step] * (candlen < width ? candlen : width));
+        steplens[step] = 0;
+        for (i = 0; i < candlen && steplens[step] < width; i++)
+        {
+            if (i > 0 && candidates[i].bits == candidates[i-1].bits)
+                continue;
+            steps[step][steplens[step]++] = candidates[i];
+        }
+    }
+
+    // any state of the last step has the fewest marbles; follow its parents back to the start
+    unsigned long long chain[MAX_CHAIN_LEN];
+    int index = 0;
+    for (i = step; i >= 0; i--)
+    {
+        chain[i] = steps[i][index].bits;
+        index = steps[i][index].pindex;
+    }
+    save_bits_chain(chain, step + 1);
+
+    for (i = 0; i <= step; i++)
+        free(steps[i]);
+    free(candidates);
+    return count_bits(startbits) - step;
+}
+
+// returns the best marble count found, and saves its chain into solarr
+int solve_beam(unsigned long long startbits, int targetct, int width, unsigned long long *checked, unsigned long long *generated)
+{
+    int bestct = count_bits(startbits);
+    state_t *bestsol = NULL;
+    int bestsollen = 0;
+    for (;; width *= 2)
+    {
+        int ct = beam_search(startbits, targetct, width, checked, generated);
+        if (ct < bestct)
+        {
+            bestct = ct;
+            printf("Found new best state with %d marbles remaining (base16: 0x %012llx) at beam width %d.\n",
+                   bestct, solarr[solarrlen-1].bits, width);
+            // keep this chain, in case a wider search is cut short by the time limit
+            free(bestsol);
+            bestsol = solarr;
+            bestsollen = solarrlen;
+            solarr = NULL;
+        }
+        // without a time limit, search the requested width only
+        if (bestct <= targetct || search_deadline <= 0 || out_of_time())
+            break;
+    }
+    free(solarr);
+    solarr = bestsol;
+    solarrlen = bestsollen;
+    return bestct;
+}
+
+
+// ===================================
+// board symmetry
+//   The board looks the same rotated or mirrored, and so do the marble counts reachable from a state.
+//   A state's canonical form is the smallest of its symmetric images: all 8 for the French and English boards,
+//   or those of the 8 that map the holes of a custom board onto themselves.
+
+// sym_rows[t][r][v] is the image, under symmetry t, of row r holding the 7 bits v
+unsigned long long sym_rows[8][7][128];
+// the symmetries of the board's holes (always starting with the identity, 0)
+int sym_group[8];
+int sym_group_len = 1;
+
+static inline unsigned long long transform_bits(const unsigned long long bits, const int t)
+{
+    unsigned long long image = 0uLL;
+    int r;
+    for (r = 0; r < 7; r++)
+        image |= sym_rows[t][r][(bits >> (42 - 7*r)) & 127];
+    return image;
+}
+
+void init_symmetry()
+{
+    int t, r, c, v;
+    for (t = 0; t < 8; t++)
+        for (r = 0; r < 7; r++)
+            for (v = 0; v < 128; v++)
+            {
+                unsigned long long image = 0uLL;
+                for (c = 0; c < 7; c++)
+                {
+                    if (!(v & (1 << (6 - c))))
+                        continue;
+                    int tr, tc;
+                    switch (t) {
+                        case 0:  tr = r;     tc = c;     break; // identity
+                        case 1:  tr = c;     tc = 6 - r; break; // rotate 90
+                        case 2:  tr = 6 - r; tc = 6 - c; break; // rotate 180
+                        case 3:  tr = 6 - c; tc = r;     break; // rotate 270
+                        case 4:  tr = r;     tc = 6 - c; break; // mirror left-right
+                        case 5:  tr = 6 - r; tc = c;     break; // mirror top-bottom
+                        case 6:  tr = c;     tc = r;     break; // mirror on the main diagonal
+                        default: tr = 6 - c; tc = 6 - r; break; // mirror on the other diagonal
+                    }
+                    image = set_marble(image, tr, tc);
+                }
+                sym_rows[t][r][v] = image;
+            }
+    sym_group_len = 0;
+    for (t = 0; t < 8; t++)
+        if (transform_bits(board_holes, t) == board_holes)
+            sym_group[sym_group_len++] = t;
+}
+
+unsigned long long canonical_bits(unsigned long long bits)
+{
+    unsigned long long best = bits, image;
+    int i;
+    for (i = 1; i < sym_group_len; i++)
+        if ((image = transform_bits(bits, sym_group[i])) < best)
+            best = image;
+    return best;
+}
+
+
+// ===================================
+// lower bound on the final marble count
+//   Color the holes three ways along each diagonal direction ((r+c) mod 3, and (r-c) mod 3).
+//   A move's three holes have three different colors, so every move flips the parity of the number of marbles
+//   on every color. A state's 6 color parities can therefore only end up as themselves (after an even number of moves)
+//   or all flipped (odd), and no final board can have fewer marbles than the smallest board with those parities.
+
+unsigned long long color_masks[6];
+// the fewest marbles of any board with the given 6 color parities
+int class_minct[64];
+
+static inline int color_class(const unsigned long long bits)
+{
+    int class = 0, k;
+    for (k = 0; k < 6; k++)
+        class |= (__builtin_popcountll(bits & color_masks[k]) & 1) << k;
+    return class;
+}
+
+void init_class_bound()
+{
+    int r, c, k;
+    int cells[MAX_BOARD_CT];
+    int cellct = 0;
+    // a diagonal jump along a line of one color flips the parity of just that color; no bound then
+    if (dirs_len > ORTHOGONAL_DIRS_LEN)
+    {
+        for (k = 0; k < 64; k++)
+            class_minct[k] = 1;
+        return;
+    }
+    for (r = 0; r < 7; r++)
+        for (c = 0; c < 7; c++)
+            if (is_marble(board_holes, r, c))
+            {
+                color_masks[(r + c) % 3] = set_marble(color_masks[(r + c) % 3], r, c);
+                color_masks[3 + (r - c + 6) % 3] = set_marble(color_masks[3 + (r - c + 6) % 3], r, c);
+                cells[cellct++] = r * 7 + c;
+            }
+    // every class has a board of at most 4 marbles; boards of 5 are never needed to be looked at
+    for (k = 0; k < 64; k++)
+        class_minct[k] = 5;
+    int a, b, d, e;
+    for (a = 0; a < cellct; a++)
+        for (b = a; b < cellct; b++)
+            for (d = b; d < cellct; d++)
+                for (e = d; e < cellct; e++)
+                {
+                    // repeated cells stand for fewer marbles (a == b is a one marble board, and so on)
+                    unsigned long long bits = set_marble(0uLL, cells[a] / 7, cells[a] % 7);
+                    if (b != a) bits = set_marble(bits, cells[b] / 7, cells[b] % 7);
+                    if (d != b) bits = set_marble(bits, cells[d] / 7, cells[d] % 7);
+                    if (e != d) bits = set_marble(bits, cells[e] / 7, cells[e] % 7);
+                    int class = color_class(bits), ct = count_bits(bits);
+                    if (ct < class_minct[class])
+                        class_minct[class] = ct;
+                }
+}
+
+// fewest marbles any board reachable from this one could have
+static inline int final_ct_lower_bound(const unsigned long long bits)
+{
+    int class = color_class(bits);
+    int even = class_minct[class], odd = class_minct[class ^ 63];
+    return even < odd ? even : odd;
+}
+
+
+// ===================================
+// large table allocation
+//   The visited-state cache and the tablebase layers are probed at random over many megabytes, where most probes
+//   would miss the TLB and the first touch of each page faults. So they are mapped on 2 MB huge pages when possible:
+//   explicit ones (MAP_HUGETLB, if the system has reserved some), else transparent ones (MADV_HUGEPAGE on an aligned
+//   mapping), else plain pages. With --huge-pages prefault, the table is also touched by threads up front,
+//   so its pages are in place before the search starts; the page sizes actually backing it are then reported.
+
+#define BIG_ALLOC_PAGE (2uLL << 20)     // huge page size asked for; smaller tables just use calloc()
+#define HUGE_PAGES_OFF 0
+#define HUGE_PAGES_ON 1
+#define HUGE_PAGES_PREFAULT 2
+
+int huge_pages = HUGE_PAGES_ON;
+int prefault_threads = 1;
+
+typedef struct {
+    char *start;
+    size_t len;
+} prefault_job_t;
+
+void *prefault_worker(void *arg)
+{
+    prefault_job_t *job = (prefault_job_t*) arg;
+    size_t i;
+    // a write per 4 kB page: faults it in, or its whole huge page with the first write
+    for (i = 0; i < job->len; i += 4096)
+        job->start[i] = 0;
+    return NULL;
+}
+
+void prefault(void *ptr, size_t bytes, int threads)
+{
+    prefault_job_t jobs[threads];
+    pthread_t tids[threads];
+    size_t slice = (bytes / threads + BIG_ALLOC_PAGE - 1) / BIG_ALLOC_PAGE * BIG_ALLOC_PAGE;
+    int t;
+    for (t = 0; t < threads; t++)
+    {
+        size_t begin = slice * t < bytes ? slice * t : bytes;
+        jobs[t] = (prefault_job_t){ .start = (char*) ptr + begin, .len = bytes - begin < slice ? bytes - begin : slice };
+        if (pthread_create(&tids[t], NULL, prefault_worker, &jobs[t]) != 0)
+        {
+            perror("pthread_create() failed");
+            exit(1);
+        }
+    }
+    for (t = 0; t < threads; t++)
+        pthread_join(tids[t], NULL);
+}
+
+// kB of the mapping holding ptr that are backed by transparent huge pages, or -1 if it cannot be told
+long long huge_page_kb(const void *ptr)
+{
+    long long kb = -1;
+#ifdef __linux__
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    char line[512];
+    bool inside = false;
+    if (!smaps)
+        return -1;
+    while (fgets(line, sizeof line, smaps))
+    {
+        unsigned long long lo, hi;
+        if (sscanf(line, "%llx-%llx ", &lo, &hi) == 2)
+            inside = lo <= (unsigned long long) (uintptr_t) ptr && (unsigned long long) (uintptr_t) ptr < hi;
+        else if (inside && sscanf(line, "AnonHugePages: %lld kB", &kb) == 1)
+            break;
+    }
+    fclose(smaps);
+#endif
+    return kb;
+}
+
+// zeroed memory for a large table, on huge pages if possible; what names the table in the report (NULL for none)
+void *big_alloc(size_t bytes, const char *what)
+{
+    void *ptr = NULL;
+    const char *pages = "on 4 kB pages";
+    bool transparent = false;
+    if (bytes < BIG_ALLOC_PAGE || huge_pages == HUGE_PAGES_OFF)
+        return calloc(bytes, 1);
+    bytes = (bytes + BIG_ALLOC_PAGE - 1) / BIG_ALLOC_PAGE * BIG_ALLOC_PAGE;
+#if defined(MAP_HUGETLB)
+    ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED)
+        pages = "on 2 MB huge pages (MAP_HUGETLB)";
+    else
+#endif
+    {
+        // aligned to a huge page, by mapping one more and trimming the ends
+        char *raw = mmap(NULL, bytes + BIG_ALLOC_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return NULL;
+        char *aligned = (char*) (((uintptr_t) raw + BIG_ALLOC_PAGE - 1) & ~(uintptr_t) (BIG_ALLOC_PAGE - 1));
+        if (aligned > raw)
+            munmap(raw, aligned - raw);
+        munmap(aligned + bytes, raw + BIG_ALLOC_PAGE - aligned);
+        ptr = aligned;
+#if defined(MADV_HUGEPAGE)
+        // (the kernel only backs it with huge pages as it is touched, if it has them then)
+        transparent = madvise(ptr, bytes, MADV_HUGEPAGE) == 0;
+        if (transparent)
+            pages = "with transparent huge pages requested (madvise)";
+        else
+            pages = "on 4 kB pages (transparent huge pages are not available)";
+#endif
+    }
+    if (huge_pages == HUGE_PAGES_PREFAULT)
+    {
+        double start = now_seconds();
+        prefault(ptr, bytes, prefault_threads);
+        if (what)
+        {
+            long long kb = transparent ? huge_page_kb(ptr) : -1;
+            printf("Info: %s: %zu MB %s, prefaulted in %.2f s", what, bytes >> 20, pages, now_seconds() - start);
+            if (kb >= 0)
+                printf(", %lld MB of it on huge pages", kb >> 10);
+            printf(".\n");
+        }
+    }
+    else if (what)
+        printf("Info: %s: %zu MB %s.\n", what, bytes >> 20, pages);
+    return ptr;
+}
+
+// frees a table from big_alloc(), given the same size
+void big_free(void *ptr, size_t bytes)
+{
+    if (!ptr)
+        return;
+    if (bytes < BIG_ALLOC_PAGE || huge_pages == HUGE_PAGES_OFF)
+        free(ptr);
+    else
+        munmap(ptr, (bytes + BIG_ALLOC_PAGE - 1) / BIG_ALLOC_PAGE * BIG_ALLOC_PAGE);
+}
+
+
+// ===================================
+// visited-state cache
+//   An open addressing hash table of canonical board states. Each slot packs the 49 board bits
+//   with the lower bound (bits 56 and up) proven for the fewest marbles reachable from that board,
+//   and a flag (CACHE_EXACT) once that bound is known to be reached.
+//   A board may sit in any of CACHE_PROBE_LEN slots from its hash; when they are all taken,
+//   the slot with the least useful (smallest) bound is replaced.
+//   Slots are read and written whole with relaxed atomics, so threads may share a cache:
+//   a race can only lose an entry, never mix up two.
+
+#define CACHE_KEY_BITS ((1uLL << 49) - 1)
+#define CACHE_VALUE_SHIFT 56
+#define CACHE_BOUND_MASK 0x3F
+#define CACHE_EXACT 0x40
+
+typedef struct {
+    unsigned long long *table;
+    unsigned long long mask;    // number of slots - 1 (a power of two)
+} cache_t;
+
+cache_t vcache;
+
+void cache_init(cache_t *cache, unsigned long long megabytes)
+{
+    unsigned long long slots = 1;
+    while (slots * 2 * sizeof *cache->table <= megabytes << 20)
+        slots *= 2;
+    cache->table = (unsigned long long*) big_alloc(slots * sizeof *cache->table, "Visited-state cache");
+    if (!cache->table)
+    {
+        perror("cache_init() failed");
+        exit(1);
+    }
+    cache->mask = slots - 1;
+}
+
+static inline unsigned long long cache_slot(const cache_t *cache, const unsigned long long key)
+{
+    return ((key * 0x9E3779B97F4A7C15uLL) >> 20) & cache->mask;
+}
+
+// the stored value of a board (its lower bound, or'd with CACHE_EXACT if reached), or 0 if it is not in the cache
+int cache_lookup(const cache_t *cache, unsigned long long key)
+{
+    unsigned long long slot = cache_slot(cache, key);
+    int i;
+    for (i = 0; i < CACHE_PROBE_LEN; i++)
+    {
+        unsigned long long entry = __atomic_load_n(&cache->table[(slot + i) & cache->mask], __ATOMIC_RELAXED);
+        if ((entry & CACHE_KEY_BITS) == key)
+            return (int) (entry >> CACHE_VALUE_SHIFT);
+        if (!entry)
+            return 0;
+    }
+    return 0;
+}
+
+// the stored lower bound of a board, or 0 if it is not in the cache
+static inline int cache_get(const cache_t *cache, unsigned long long key)
+{
+    return cache_lookup(cache, key) & CACHE_BOUND_MASK;
+}
+
+// stores a value (a lower bound, maybe or'd with CACHE_EXACT); a board's stored bound is never lowered
+void cache_put(cache_t *cache, unsigned long long key, int value)
+{
+    unsigned long long slot = cache_slot(cache, key);
+    unsigned long long victim = slot;
+    int victimvalue = INT_MAX;
+    int i;
+    for (i = 0; i < CACHE_PROBE_LEN; i++)
+    {
+        unsigned long long index = (slot + i) & cache->mask;
+        unsigned long long entry = __atomic_load_n(&cache->table[index], __ATOMIC_RELAXED);
+        if (!entry)
+        {
+            victim = index;
+            break;
+        }
+        int stored = (int) (entry >> CACHE_VALUE_SHIFT);
+        if ((entry & CACHE_KEY_BITS) == key)
+        {
+            if ((stored & CACHE_EXACT) || (stored & CACHE_BOUND_MASK) > (value & CACHE_BOUND_MASK))
+                return;
+            victim = index;
+            break;
+        }
+        if ((stored & CACHE_BOUND_MASK) < victimvalue)
+        {
+            victim = index;
+            victimvalue = stored & CACHE_BOUND_MASK;
+        }
+    }
+    __atomic_store_n(&cache->table[victim], key | ((unsigned long long) value << CACHE_VALUE_SHIFT), __ATOMIC_RELAXED);
+}
+
+
+// ===================================
+// iterative deepening engine
+//   Tries to reach a board with at most bound marbles, for bound = 1, 2, 3...
+//   Each failed iteration proves the bound unreachable, so the first success is the minimum.
+//   States proven unable to reach a bound are cached (by canonical form) with bound + 1 as their
+//   lower bound, which carries over into all later iterations.
+
+typedef struct {
+    unsigned long long path[MAX_CHAIN_LEN]; // the line being searched, path[0] being the starting state
+    int pathlen;                            // length of the line that reached the bound, once found
+    unsigned long long best[MAX_CHAIN_LEN]; // the line to the fewest marbles seen so far, kept while bestct is above 0
+    int bestlen, bestct;
+    bool aborted;                           // ran out of time; the failures found since prove nothing
+    unsigned long long checked, generated;
+} ida_ctx_t;
+
+// can a board with at most bound marbles be reached from bits (which is path[depth])?
+bool ida_search(ida_ctx_t *ctx, unsigned long long bits, int ct, int bound, int depth)
+{
+    ctx->path[depth] = bits;
+    ctx->checked++;
+    if (ct < ctx->bestct)
+    {
+        memcpy(ctx->best, ctx->path, sizeof *ctx->path * (depth + 1));
+        ctx->bestlen = depth + 1;
+        ctx->bestct = ct;
+    }
+    if (ct <= bound)
+    {
+        if (profiling)
+        {
+            profile.nodes[ct]++;
+            profile.solutions[ct]++;
+        }
+        ctx->pathlen = depth + 1;
+        return true;
+    }
+    if ((ctx->checked & 0xFFF) == 0)
+    {
+        if (profiling)
+            profile_sample(ct);
+        if (out_of_time())
+            ctx->aborted = true;
+    }
+    if (ctx->aborted)
+        return false;
+    // (profile) the states checked here on are the cache probes, less the ones cut off by the bound
+    if (profiling)
+        profile.nodes[ct]++;
+    if (final_ct_lower_bound(bits) > bound)
+    {
+        if (profiling)
+            profile.bound_prunes[ct]++;
+        return false;
+    }
+    unsigned long long key = canonical_bits(bits);
+    int cached = cache_get(&vcache, key);
+    if (cached > bound)
+    {
+        if (profiling)
+            profile.cache_prunes[ct]++;
+        return false;
+    }
+    if (profiling)
+        profile.cache_hits[ct] += cached > 0;
+
+    unsigned long long children[MAX_CHILDREN];
+    long scores[MAX_CHILDREN];
+    int n = gen_children(bits, children);
+    ctx->generated += n;
+    if (profiling && n == 0)
+        profile.dead_ends[ct]++;
+    int i, j;
+    // search the most promising children first; that only matters for the iteration that succeeds
+    for (i = 0; i < n; i++)
+    {
+        unsigned long long child = children[i];
+        long score = board_compactness(child);
+        for (j = i; j > 0 && scores[j-1] < score; j--)
+        {
+            children[j] = children[j-1];
+            scores[j] = scores[j-1];
+        }
+        children[j] = child;
+        scores[j] = score;
+    }
+    for (i = 0; i < n; i++)
+    {
+        unsigned long long before = ctx->checked;
+        bool found = ida_search(ctx, children[i], ct - 1, bound, depth + 1);
+        if (profiling && depth == 0)
+            profile_root_child(children[i], ctx->checked - before);
+        if (found)
+            return true;
+    }
+    if (!ctx->aborted)
+        cache_put(&vcache, key, bound + 1);
+    return false;
+}
+
+// returns the minimum reachable marble count (or the best found, if out of time), and saves its chain into solarr.
+// With a threshold above the lower bound, the first iteration tries the threshold itself, and a board
+// within it is only proven optimal if that iteration fails.
+int solve_ida(unsigned long long startbits, int targetct, unsigned long long *checked, unsigned long long *generated)
+{
+    ida_ctx_t ctx = { .checked = 0, .generated = 0, .aborted = false, .bestct = INT_MAX };
+    int startct = count_bits(startbits);
+    int lowerbound = final_ct_lower_bound(startbits);
+    printf("Lower bound on the final marble count: %d.\n", lowerbound);
+    const int firstbound = targetct > lowerbound ? targetct : lowerbound;
+    int bound = firstbound;
+    for (; bound < startct; bound++)
+    {
+        if (ida_search(&ctx, startbits, startct, bound, 0))
+            break;
+        if (ctx.aborted)
+            break;
+        printf("Proved no board with %d marble%s can be reached (checked %llu states so far).\n",
+               bound, bound==1?"":"s or less", ctx.checked);
+    }
+    *checked += ctx.checked;
+    *generated += ctx.generated;
+    if (ctx.aborted)
+    {
+        // the line to the fewest marbles the search got to, which proves nothing
+        printf("Found new best state with %d marbles remaining (base16: 0x %012llx).\n",
+               ctx.bestct, ctx.best[ctx.bestlen-1]);
+        save_bits_chain(ctx.best, ctx.bestlen);
+        return ctx.bestct;
+    }
+    if (bound >= startct)
+    {
+        // no move at all can be made, or the start is within the threshold already
+        ctx.path[0] = startbits;
+        ctx.pathlen = 1;
+        bound = startct;
+    }
+    printf("Found new best state with %d marbles remaining (base16: 0x %012llx)%s.\n",
+           bound, ctx.path[ctx.pathlen-1], bound > firstbound || firstbound == lowerbound ? ", proven optimal" : "");
+    save_bits_chain(ctx.path, ctx.pathlen);
+    return bound;
+}
+
+
+// the fewest marbles reachable from bits, proven, with a line reaching it left in ctx->path; -1 if out of time.
+// Every board of that line is cached as exact, so asking again as the line is played out is quick.
+int ida_solve_exact(ida_ctx_t *ctx, unsigned long long bits)
+{
+    int ct = count_bits(bits);
+    int bound = final_ct_lower_bound(bits);
+    int cached = cache_get(&vcache, canonical_bits(bits));
+    int i;
+    if (cached > bound)
+        bound = cached;
+    for (; bound < ct; bound++)
+    {
+        if (ida_search(ctx, bits, ct, bound, 0))
+            break;
+        if (ctx->aborted)
+            return -1;
+    }
+    if (bound >= ct)
+    {
+        ctx->path[0] = bits;
+        ctx->pathlen = 1;
+        bound = ct;
+    }
+    // nothing below bound is reachable from the start, so neither is it from any board after it
+    for (i = 0; i < ctx->pathlen; i++)
+        cache_put(&vcache, canonical_bits(ctx->path[i]), bound | CACHE_EXACT);
+    return bound;
+}
+
+
+// ===================================
+// sharded search
+//   --split-depth plans a search: every distinct state reachable in depth moves (and any dead end before that)
+//   is dealt round-robin into shard files in a work directory, each with its line of states from the start.
+//   Each --shard run searches below the states of its own shard file and writes a result file,
+//   and --merge combines the result files. Everything is plain text files in the one directory.
+
+#define PLAN_FILE "plan.txt"
+
+typedef struct {
+    unsigned long long start_bits;
+    unsigned long long target_bits;     // 0 if solving for a marble count
+    int target_count;                   // 0 if not specified (the default threshold)
+    unsigned long long holes;           // the board (--board) and its moves (--diagonal) the plan was made on
+    int diagonal;
+    int depth;
+    int shards;
+    long states;
+} split_plan_t;
+
+typedef struct {
+    unsigned long long bits;
+    int pindex;                 // index of parent state in the previous layer
+} split_entry_t;
+
+typedef struct {
+    unsigned long long key;
+    int index;
+} split_key_t;
+
+int split_key_cmp(const void *a, const void *b)
+{
+    const split_key_t *ka = a, *kb = b;
+    if (ka->key != kb->key)
+        return ka->key < kb->key ? -1 : 1;
+    return ka->index - kb->index;
+}
+
+void work_file_path(char *path, size_t pathlen, const char *dir, const char *kind, int index, int count)
+{
+    if (index < 0)
+        snprintf(path, pathlen, "%s/%s", dir, kind);
+    else
+        snprintf(path, pathlen, "%s/%s_%d_of_%d.txt", dir, kind, index, count);
+}
+
+FILE *open_work_file(const char *dir, const char *kind, int index, int count, const char *mode)
+{
+    char path[4096];
+    work_file_path(path, sizeof path, dir, kind, index, count);
+    FILE *file = fopen(path, mode);
+    if (!file)
+    {
+        fprintf(stderr, "Could not open \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+    return file;
+}
+
+// writes the plan file and the shard files; returns the number of states split
+long write_split_plan(split_plan_t *plan, const char *dir)
+{
+    // when solving for a count, symmetric states have the same outcome, so only one of them needs searching
+    bool by_symmetry = !plan->target_bits;
+    if (by_symmetry)
+        init_symmetry();
+    // every state of a layer has the same marble count, so the layer at the solution's count is as deep as the split
+    // goes: its states are solutions (or the target, or can never reach it), and are dealt out as they are
+    int startct = count_bits(plan->start_bits);
+    int targetct = plan->target_bits ? count_bits(plan->target_bits) : plan->target_count ? plan->target_count : 1;
+    if (plan->depth > startct - targetct)
+    {
+        plan->depth = startct > targetct ? startct - targetct : 0;
+        printf("Info: The split depth is cut to %d, where the states have %d marbles.\n", plan->depth, startct - plan->depth);
+    }
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Could not create work directory \"%s\": %s\n", dir, strerror(errno));
+        exit(1);
+    }
+
+    FILE *shardfiles[plan->shards];
+    int i, j, n, d;
+    for (i = 0; i < plan->shards; i++)
+        shardfiles[i] = open_work_file(dir, "shard", i, plan->shards, "w");
+
+    split_entry_t *layers[MAX_CHAIN_LEN];
+    int layerlens[MAX_CHAIN_LEN];
+    unsigned long long children[MAX_CHILDREN];
+    unsigned long long chain[MAX_CHAIN_LEN];
+    layers[0] = (split_entry_t*) malloc(sizeof *layers[0]);
+    layers[0][0] = (split_entry_t){ .bits = plan->start_bits, .pindex = -1 };
+    layerlens[0] = 1;
+    long written = 0;
+    for (d = 0; d <= plan->depth && d < MAX_CHAIN_LEN; d++)
+    {
+        // expand the layer, dealing out its dead ends (and the whole last layer) as states to search
+        split_entry_t *next = NULL;
+        split_key_t *keys = NULL;
+        int nextlen = 0, capacity = 0;
+        for (i = 0; i < layerlens[d]; i++)
+        {
+            n = d < plan->depth ? gen_children(layers[d][i].bits, children) : 0;
+            if (n == 0)
+            {
+                int index = i, k;
+                for (k = d; k >= 0; k--)
+                {
+                    chain[k] = layers[k][index].bits;
+                    index = layers[k][index].pindex;
+                }
+                FILE *file = shardfiles[written % plan->shards];
+                for (k = 0; k <= d; k++)
+                    fprintf(file, "%s%012llx", k ? " " : "", chain[k]);
+                fputc('\n', file);
+                written++;
+                continue;
+            }
+            if (nextlen + n > capacity)
+            {
+                capacity = (nextlen + n) * 2;
+                next = (split_entry_t*) realloc(next, sizeof *next * capacity);
+                keys = (split_key_t*) realloc(keys, sizeof *keys * capacity);
+            }
+            for (j = 0; j < n; j++)
+            {
+                keys[nextlen] = (split_key_t){ .key = by_symmetry ? canonical_bits(children[j]) : children[j], .index = nextlen };
+                next[nextlen++] = (split_entry_t){ .bits = children[j], .pindex = i };
+            }
+        }
+        if (nextlen == 0)
+            break;
+        // keep the first of each distinct state
+        qsort(keys, nextlen, sizeof *keys, split_key_cmp);
+        layers[d+1] = (split_entry_t*) malloc(sizeof *layers[d+1] * nextlen);
+        layerlens[d+1] = 0;
+        for (i = 0; i < nextlen; i++)
+            if (i == 0 || keys[i].key != keys[i-1].key)
+                layers[d+1][layerlens[d+1]++] = next[keys[i].index];
+        free(next);
+        free(keys);
+        printf("Split depth %d: %d distinct states.\n", d + 1, layerlens[d+1]);
+    }
+    for (i = 0; i <= d && i < MAX_CHAIN_LEN; i++)
+        free(layers[i]);
+    for (i = 0; i < plan->shards; i++)
+        fclose(shardfiles[i]);
+
+    plan->states = written;
+    plan->holes = board_holes;
+    plan->diagonal = dirs_len > ORTHOGONAL_DIRS_LEN;
+    FILE *planfile = open_work_file(dir, PLAN_FILE, -1, 0, "w");
+    fprintf(planfile, "start %012llx\ntarget %012llx\ncount %d\nboard %012llx\ndiagonal %d\ndepth %d\nshards %d\nstates %ld\n",
+            plan->start_bits, plan->target_bits, plan->target_count, plan->holes, plan->diagonal,
+            plan->depth, plan->shards, plan->states);
+    fclose(planfile);
+    return written;
+}
+
+// reads the plan file, which must have been made on the same board as the one chosen now
+void read_split_plan(split_plan_t *plan, const char *dir)
+{
+    FILE *planfile = open_work_file(dir, PLAN_FILE, -1, 0, "r");
+    if (fscanf(planfile, "start %llx target %llx count %d board %llx diagonal %d depth %d shards %d states %ld",
+               &plan->start_bits, &plan->target_bits, &plan->target_count, &plan->holes, &plan->diagonal,
+               &plan->depth, &plan->shards, &plan->states) != 8)
+    {
+        fprintf(stderr, "Malformed plan file in \"%s\".\n", dir);
+        exit(1);
+    }
+    fclose(planfile);
+    if (plan->holes != board_holes || plan->diagonal != (dirs_len > ORTHOGONAL_DIRS_LEN))
+    {
+        fprintf(stderr, "The plan in \"%s\" was made on a different board (0x %012llx%s)!"
+                        " Give the same --board and --diagonal as when planning.\n",
+                dir, plan->holes, plan->diagonal ? ", with diagonal jumps" : "");
+        exit(1);
+    }
+}
+
+// searches every state of one shard, and writes its result file.
+// Returns the best marble count found, and saves its chain into solarr.
+int solve_shard(const split_plan_t *plan, const char *dir, int index, int count, int targetct,
+                unsigned long long *checked, unsigned long long *generated)
+{
+    FILE *shardfile = open_work_file(dir, "shard", index, count, "r");
+    unsigned long long prefix[MAX_CHAIN_LEN], best[MAX_CHAIN_LEN];
+    int prefixlen, bestlen = 0, i;
+    int bestct = count_bits(plan->start_bits);
+    bool found = false;
+    long total = 0, searched = 0;
+    char line[MAX_CHAIN_LEN * 16];
+    if (search_engine == ENGINE_IDA)
+    {
+        init_symmetry();
+        init_class_bound();
+    }
+    while (fgets(line, sizeof line, shardfile))
+    {
+        // parse the line from the start to this state
+        char *pos = line, *end;
+        prefixlen = 0;
+        while (prefixlen < MAX_CHAIN_LEN)
+        {
+            unsigned long long bits = strtoull(pos, &end, 16);
+            if (end == pos)
+                break;
+            prefix[prefixlen++] = bits;
+            pos = end;
+        }
+        if (prefixlen == 0)
+            continue;
+        total++;
+        if (found || __atomic_load_n(&timed_out, __ATOMIC_RELAXED))
+            continue; // only counting the rest
+
+        // search below the state
+        // note: a state at the split depth may be the solution itself, which needs no search below it;
+        //   e.g. -x 61b2200a061c -t 60b02002161c --split-depth 2 finds its target in shard 0,
+        //   and so does --split-depth 3, which the planner cuts to 2 (the target's depth).
+        unsigned long long last = prefix[prefixlen-1];
+        free(solarr);
+        solarr = NULL;
+        solarrlen = 0;
+        int ct = count_bits(last);
+        if (plan->target_bits ? last == plan->target_bits : ct <= targetct)
+        {
+            // (checked, like the start of a search)
+            (*checked)++;
+            save_bits_chain(&last, 1);
+        }
+        else if (search_engine == ENGINE_IDA)
+            ct = solve_ida(last, targetct, checked, generated);
+        else
+        {
+            sarr[0] = (state_t){ .bits = last, .ct = count_bits(last), .pindex = -1, .visited = false };
+            sarrlen = 1;
+            ct = solve_dfs(plan->target_bits, targetct, checked, generated);
+        }
+        if (__atomic_load_n(&timed_out, __ATOMIC_RELAXED))
+            continue;
+        searched++;
+        if (plan->target_bits ? !(solarr && solarr[solarrlen-1].bits == plan->target_bits)
+                              : (ct >= bestct && bestlen > 0))
+            continue;
+        // a new best for the shard: the prefix, then the chain below it (which starts with the state itself)
+        bestct = ct;
+        found = plan->target_bits || ct <= targetct;
+        memcpy(best, prefix, sizeof *prefix * prefixlen);
+        bestlen = prefixlen;
+        for (i = 1; i < solarrlen && bestlen < MAX_CHAIN_LEN; i++)
+            best[bestlen++] = solarr[i].bits;
+    }
+    fclose(shardfile);
+
+    FILE *resultfile = open_work_file(dir, "result", index, count, "w");
+    fprintf(resultfile, "shard %d %d\nstates %ld %ld\nchecked %llu\ngenerated %llu\nbest %d\nfound %d\nchain %d\n",
+            index, count, searched, total, *checked, *generated, bestct, found ? 1 : 0, bestlen);
+    for (i = 0; i < bestlen; i++)
+        fprintf(resultfile, "%012llx\n", best[i]);
+    fclose(resultfile);
+    printf("Shard %d of %d: searched %ld of %ld states%s.\n", index, count, searched, total,
+           found ? " (stopped early: solution found)" : "");
+
+    if (bestlen > 0)
+        save_bits_chain(best, bestlen);
+    else
+    {
+        free(solarr);
+        solarr = NULL;
+        solarrlen = 0;
+    }
+    return bestct;
+}
+
+// combines every shard's result file. Returns the best marble count found, and saves its chain into solarr.
+int merge_shard_results(const split_plan_t *plan, const char *dir, unsigned long long *checked, unsigned long long *generated)
+{
+    unsigned long long chain[MAX_CHAIN_LEN];
+    int bestct = count_bits(plan->start_bits);
+    bool bestfound = false, anychain = false;
+    int i, j, missing = 0, unfinished = 0;
+    for (i = 0; i < plan->shards; i++)
+    {
+        char path[4096];
+        work_file_path(path, sizeof path, dir, "result", i, plan->shards);
+        FILE *resultfile = fopen(path, "r");
+        if (!resultfile)
+        {
+            fprintf(stderr, "Warning: no result yet for shard %d of %d (\"%s\").\n", i, plan->shards, path);
+            missing++;
+            continue;
+        }
+        int shard, shards, ct, found, chainlen;
+        long searched, total;
+        unsigned long long shardchecked, shardgenerated;
+        if (fscanf(resultfile, "shard %d %d states %ld %ld checked %llu generated %llu best %d found %d chain %d",
+                   &shard, &shards, &searched, &total, &shardchecked, &shardgenerated, &ct, &found, &chainlen) != 9
+            || chainlen < 0 || chainlen > MAX_CHAIN_LEN)
+        {
+            fprintf(stderr, "Malformed result file \"%s\".\n", path);
+            exit(1);
+        }
+        *checked += shardchecked;
+        *generated += shardgenerated;
+        if (searched < total)
+        {
+            // a shard that stopped early because it found a solution is as good as finished
+            if (!found)
+            {
+                fprintf(stderr, "Warning: shard %d of %d only searched %ld of %ld states.\n", i, plan->shards, searched, total);
+                unfinished++;
+            }
+        }
+        bool better = plan->target_bits ? (found && !bestfound) : (chainlen > 0 && (ct < bestct || !anychain));
+        if (better)
+        {
+            for (j = 0; j < chainlen; j++)
+                if (fscanf(resultfile, "%llx", &chain[j]) != 1)
+                {
+                    fprintf(stderr, "Malformed result file \"%s\".\n", path);
+                    exit(1);
+                }
+            save_bits_chain(chain, chainlen);
+            bestct = ct;
+            bestfound = found;
+            anychain = true;
+        }
+        fclose(resultfile);
+    }
+    printf("Merged %d of %d shard results", plan->shards - missing, plan->shards);
+    if (missing || unfinished)
+        printf(" (%d missing, %d unfinished; the result may not be the best)", missing, unfinished);
+    printf(".\n");
+    if (!anychain)
+    {
+        free(solarr);
+        solarr = NULL;
+        solarrlen = 0;
+    }
+    return bestct;
+}
+
+
+unsigned long long _board_size_cap = FULL_BOARD_BITS;// (1uLL << 49);
+// parses a board state; if it is not a valid one, says why on out and returns 0
+unsigned long long read_board_state(char *arg, bool parse_dec, bool parse_hex, FILE *out)
+{
+    // will not accept both parsing options as true
+    assert(!(parse_dec && parse_hex));
+    // parse the char *arg into a number, either binary, dec, or hex
+    unsigned long long result;
+    int arglen = strlen(arg);
+    // if hex and it starts with '0x', or binary and it starts with '0b', skip past the 0x or 0b prefix.
+    if (arglen >= 2 && arg[0]=='0'
+        && ((parse_hex && arg[1]=='x') || (!parse_dec && !parse_hex && arg[1]=='b')))
+    {
+        // skip forward 2 chars
+        arg = arg+2;
+        arglen -= 2;
+    }
+    // check own stricter formatting
+    int i;
+    for (i = 0; i < arglen; i++)
+    {
+        if (parse_dec)
+        {
+            // decimal
+            if(!(arg[i] >= '0' && arg[i] <= '9'))
+                break;
+        }
+        else if (parse_hex)
+        {
+            // hex
+            if(!is_hex(arg[i]))
+                break;
+        }
+        else
+        {
+            // binary
+            if(arg[i] != '0' && arg[i] != '1')
+                break;
+        }
+    }
+
+    // parse it into a number (if stricter formatting passed)
+    if (i >= arglen) // stricter formatting passed; because for-loop completed.
+    {
+        result = strtoull(arg, NULL, parse_dec ? 10 : parse_hex ? 16 : 2);
+        if(errno == ERANGE)
+        {
+            perror("parse_board_state() failed");
+            errno = 0;
+            result = 0;
+        }
+    }
+    else // stricter formatting did not pass
+        result = 0;
+    
+    // if result == 0, presume boardstate was invalid or an error occured.
+    if (result == 0) // failed to parse successfully
+    {
+        fprintf(out, "Invalid board state representation \"%s\"; when parsing in %s.\n",
+                arg, parse_dec ? "decimal [-d]" : parse_hex ? "hex [-x]" : "binary");
+        return 0;
+    }
+    // Otherwise, check the corners are empty and it has no extra bits anywhere
+    // using the board's holes as a mask
+    if (result != (result & board_holes)) {
+        fprintf(out, "Invalid board state representation \"%s\"; when parsing in %s.\n"
+                "\tExcessive bits found in corners or to the left.\n",
+                arg, parse_dec ? "decimal [-d]" : parse_hex ? "hex [-x]" : "binary");
+        return 0;
+    }
+    return result;
+}
+
+unsigned long long parse_board_state(char *arg, bool parse_dec, bool parse_hex)
+{
+    unsigned long long result = read_board_state(arg, parse_dec, parse_hex, stderr);
+    if (result == 0)
+        exit(1);
+    return result;
+}
+
+// reads the holes of a custom board (for --board): 49 bits of 0 and 1 in reading order, anything else skipped
+unsigned long long read_board_file(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Could not open board file \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+    unsigned long long holes = 0uLL;
+    int bitct = 0, ch;
+    while ((ch = fgetc(file)) != EOF)
+        if (ch == '0' || ch == '1')
+        {
+            if (bitct < 49)
+                holes = (holes << 1) | (ch == '1');
+            bitct++;
+        }
+    fclose(file);
+    if (bitct != 49 || count_bits(holes) < 3)
+    {
+        fprintf(stderr, "Board file \"%s\" must hold 49 bits (a 7*7 grid) with at least 3 holes; found %d bits.\n", path, bitct);
+        exit(1);
+    }
+    return holes;
+}
+
+int parse_int(char *arg)
+{
+    bool problem = false;
+    int result;
+    // check own stricter formatting
+    int arglen = strlen(arg);
+    int i;
+    for (i = 0; i < arglen; i++)
+    {
+        // decimal
+        if(!(arg[i] >= '0' && arg[i] <= '9') && arg[i] != '-' && arg[i] != '+')
+            break;
+    }
+    // parse it into a number (if stricter formatting passed)
+    if (i >= arglen) // stricter formatting passed; because for-loop completed.
+    {
+        result = (int) strtol(arg, NULL, 10);
+        if(errno == ERANGE)
+        {
+            perror("parse_int() failed");
+            errno = 0;
+            problem = true;
+        }
+    }
+    else // stricter formatting did not pass
+        problem = true;
+    
+    // if result == 0, presume int was invalid or an error occured.
+    if (problem) // failed to parse successfully
+    {
+        fprintf(stderr, "Invalid number \"%s\".\n",
+                arg);
+        exit(1);
+    }
+    return result;
+}
+
+
+
+// ===================================
+// packed binary board-state files
+//   Read by memory-mapping, so a file of any size is available at once, and pages are only read as they are touched.
+
+typedef struct {
+    char magic[4];              // STATES_FILE_MAGIC
+    uint32_t version;           // STATES_FILE_VERSION
+    uint32_t flags;             // STATES_FILE_*
+    uint32_t encoding;          // STATES_ENCODING_*
+    uint64_t board_bits;        // the board's holes; files of other boards are refused
+    uint64_t count;             // number of states that follow
+} states_file_header_t;
+
+typedef struct {
+    const states_file_header_t *header;
+    const unsigned long long *states;
+    unsigned long long count;
+    void *map;
+    size_t maplen;
+} states_map_t;
+
+// writes a header and then words 64-bit words of data
+void write_packed_file(const char *path, uint32_t encoding, uint32_t flags, unsigned long long count,
+                       const unsigned long long *data, unsigned long long words)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Could not open \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+    states_file_header_t header = {
+        .version = STATES_FILE_VERSION,
+        .flags = flags,
+        .encoding = encoding,
+        .board_bits = board_holes,
+        .count = count
+    };
+    memcpy(header.magic, STATES_FILE_MAGIC, sizeof header.magic);
+    if (fwrite(&header, sizeof header, 1, file) != 1
+        || fwrite(data, sizeof *data, words, file) != words
+        || fclose(file) != 0)
+    {
+        fprintf(stderr, "Could not write \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+}
+
+void write_states_file(const char *path, const unsigned long long *states, unsigned long long count, uint32_t flags)
+{
+    write_packed_file(path, STATES_ENCODING_BITS, flags, count, states, count);
+}
+
+// a bitmap of count bits, one per state index (rank)
+void write_bitmap_file(const char *path, const unsigned long long *bitmap, unsigned long long count)
+{
+    write_packed_file(path, STATES_ENCODING_RANK_BITMAP, 0, count, bitmap, (count + 63) / 64);
+}
+
+// maps a packed binary file into memory, checking its header; exits if it is not a usable states file
+states_map_t map_states_file(const char *path, uint32_t encoding)
+{
+    states_map_t map = { 0 };
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "Could not open \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+    if ((size_t) st.st_size < sizeof *map.header)
+    {
+        fprintf(stderr, "\"%s\" is too short to be a packed board-state file.\n", path);
+        exit(1);
+    }
+    map.maplen = st.st_size;
+    map.map = mmap(NULL, map.maplen, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map.map == MAP_FAILED)
+    {
+        fprintf(stderr, "Could not map \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+    map.header = (const states_file_header_t*) map.map;
+    if (memcmp(map.header->magic, STATES_FILE_MAGIC, sizeof map.header->magic) != 0
+        || map.header->version != STATES_FILE_VERSION)
+    {
+        fprintf(stderr, "\"%s\" is not a packed board-state file (or is of another version).\n", path);
+        exit(1);
+    }
+    if (map.header->board_bits != board_holes)
+    {
+        fprintf(stderr, "\"%s\" holds states of a different board (holes 0x %012llx).\n",
+                path, (unsigned long long) map.header->board_bits);
+        exit(1);
+    }
+    if (map.header->encoding != encoding)
+    {
+        fprintf(stderr, "\"%s\" has an unexpected encoding (%u).\n", path, map.header->encoding);
+        exit(1);
+    }
+    unsigned long long words = encoding == STATES_ENCODING_BITS ? map.header->count : (map.header->count + 63) / 64;
+    if (words > (map.maplen - sizeof *map.header) / sizeof *map.states)
+    {
+        fprintf(stderr, "\"%s\" is shorter than its header says.\n", path);
+        exit(1);
+    }
+    map.states = (const unsigned long long*) (map.header + 1);
+    map.count = map.header->count;
+    return map;
+}
+
+void unmap_states_file(states_map_t *map)
+{
+    if (map->map)
+        munmap(map->map, map->maplen);
+    *map = (states_map_t){ 0 };
+}
+
+int ull_cmp(const void *a, const void *b)
+{
+    const unsigned long long ua = *(const unsigned long long*) a, ub = *(const unsigned long long*) b;
+    return ua < ub ? -1 : ua > ub;
+}
+
+// sorts and removes duplicates; returns the new count
+unsigned long long sort_unique_states(unsigned long long *states, unsigned long long count)
+{
+    if (count == 0)
+        return 0;
+    qsort(states, count, sizeof *states, ull_cmp);
+    unsigned long long i, kept = 1;
+    for (i = 1; i < count; i++)
+        if (states[i] != states[kept-1])
+            states[kept++] = states[i];
+    return kept;
+}
+
+// converts a text file of board states (one per line) to a packed binary file; returns the number of states
+unsigned long long convert_to_binary(const char *textpath, const char *binpath, bool sort, bool parse_dec, bool parse_hex)
+{
+    FILE *text = fopen(textpath, "r");
+    if (!text)
+    {
+        fprintf(stderr, "Could not open \"%s\": %s\n", textpath, strerror(errno));
+        exit(1);
+    }
+    unsigned long long *states = NULL;
+    unsigned long long count = 0, capacity = 0;
+    bool separate = false;  // a blank line came after a state: a 0 state goes before the next, as between chains
+    char line[256];
+    while (fgets(line, sizeof line, text))
+    {
+        char *state = line + strspn(line, " \t");
+        // (hex states as the solver prints them, "0x %012llx")
+        if (parse_hex && state[0] == '0' && state[1] == 'x' && state[2] == ' ')
+            state += 2 + strspn(state + 2, " ");
+        state[strcspn(state, " \t\r\n")] = '\0';
+        if (state[0] == '\0')
+        {
+            // (a sorted file is a set of states, not chains)
+            separate = count > 0 && !sort;
+            continue;
+        }
+        if (count + 2 > capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            states = (unsigned long long*) realloc(states, sizeof *states * capacity);
+        }
+        if (separate)
+            states[count++] = 0;
+        separate = false;
+        states[count++] = parse_board_state(state, parse_dec, parse_hex);
+    }
+    fclose(text);
+    if (sort)
+        count = sort_unique_states(states, count);
+    write_states_file(binpath, states, count, sort ? STATES_FILE_SORTED : 0);
+    free(states);
+    return count;
+}
+
+// converts a packed binary file to a text file of board states, one per line; returns the number of states
+unsigned long long convert_to_text(const char *binpath, const char *textpath, bool parse_dec, bool parse_hex)
+{
+    states_map_t map = map_states_file(binpath, STATES_ENCODING_BITS);
+    madvise(map.map, map.maplen, MADV_SEQUENTIAL);
+    FILE *text = fopen(textpath, "w");
+    if (!text)
+    {
+        fprintf(stderr, "Could not open \"%s\": %s\n", textpath, strerror(errno));
+        exit(1);
+    }
+    unsigned long long i;
+    char line[64];
+    for (i = 0; i < map.count; i++)
+    {
+        unsigned long long bits = map.states[i];
+        if (!bits)
+            // the 0 state between chains
+            fputc('\n', text);
+        else if (parse_dec)
+            fprintf(text, "%llu\n", bits);
+        else if (parse_hex)
+            fprintf(text, "%012llx\n", bits);
+        else
+        {
+            // the 49 bits, in reading order
+            int b;
+            for (b = 0; b < 49; b++)
+                line[b] = (bits & (1uLL << (48 - b))) ? '1' : '0';
+            line[49] = '\n';
+            fwrite(line, 1, 50, text);
+        }
+    }
+    if (fclose(text) != 0)
+    {
+        fprintf(stderr, "Could not write \"%s\": %s\n", textpath, strerror(errno));
+        exit(1);
+    }
+    unsigned long long count = map.count;
+    unmap_states_file(&map);
+    return count;
+}
+
+// makes the states of a packed binary file the target set; returns the fewest marbles of any target
+int load_target_set(const char *path, states_map_t *map)
+{
+    *map = map_states_file(path, STATES_ENCODING_BITS);
+    if (map->count == 0)
+    {
+        fprintf(stderr, "\"%s\" holds no states.\n", path);
+        exit(1);
+    }
+    if (map->header->flags & STATES_FILE_SORTED)
+    {
+        madvise(map->map, map->maplen, MADV_RANDOM);
+        target_set = map->states;
+        target_set_len = map->count;
+    }
+    else
+    {
+        // binary search needs them sorted; sort a private copy
+        fprintf(stderr, "Note: \"%s\" is not sorted; sorting it in memory (convert with --sort to skip this).\n", path);
+        unsigned long long *copy = (unsigned long long*) big_alloc(sizeof *copy * map->count, "Target set");
+        if (!copy)
+        {
+            fprintf(stderr, "Could not allocate the target set (%llu bytes).\n", sizeof *copy * map->count);
+            exit(1);
+        }
+        memcpy(copy, map->states, sizeof *copy * map->count);
+        target_set_len = sort_unique_states(copy, map->count);
+        target_set = copy;
+        unmap_states_file(map);
+    }
+    unsigned long long i;
+    int minct = board_ct;
+    for (i = 0; i < target_set_len; i++)
+    {
+        if (target_set[i] != (target_set[i] & board_holes) || target_set[i] == 0)
+        {
+            fprintf(stderr, "\"%s\" holds an invalid board state (0x %012llx).\n", path, target_set[i]);
+            exit(1);
+        }
+        int ct = __builtin_popcountll(target_set[i]);
+        if (ct < minct)
+            minct = ct;
+    }
+    return minct;
+}
+
+
+// ===================================
+// retrograde tablebase
+//   Every arrangement of k marbles on the board's holes has an index (its rank, in colexicographic order
+//   of the holes it fills), so a tablebase layer is a bitmap over all C(holes, k) arrangements:
+//   bit set if a board with at most f marbles can be reached from it.
+//   Every move removes one marble, so layer k only depends on the finished layer k - 1.
+
+#define TB_MAX_REACH 8
+#define TB_FILE_FORMAT "%s/tb_%02d_reach_%02d%s.bin"    // the last %s marks diagonal jump tablebases
+#define TB_CHUNK (1uLL << 16)   // states in each piece of work a thread takes (a multiple of 64)
+
+// holes are numbered in reading order; a compact board has bit h set if hole h holds a marble
+unsigned long long compact_rows[7][128];
+unsigned long long expand_bytes[7][256];
+unsigned long long binomial[MAX_BOARD_CT + 1][MAX_BOARD_CT + 1];
+
+void init_ranking()
+{
+    int r, c, v, h = 0;
+    int hole_of[7][7];
+    for (r = 0; r < 7; r++)
+        for (c = 0; c < 7; c++)
+            hole_of[r][c] = is_marble(board_holes, r, c) ? h++ : -1;
+    for (r = 0; r < 7; r++)
+        for (v = 0; v < 128; v++)
+        {
+            compact_rows[r][v] = 0uLL;
+            for (c = 0; c < 7; c++)
+                if ((v & (1 << (6 - c))) && hole_of[r][c] >= 0)
+                    compact_rows[r][v] |= 1uLL << hole_of[r][c];
+        }
+    int byte;
+    for (byte = 0; byte < 7; byte++)
+        for (v = 0; v < 256; v++)
+        {
+            expand_bytes[byte][v] = 0uLL;
+            for (r = 0; r < 7; r++)
+                for (c = 0; c < 7; c++)
+                    if (hole_of[r][c] >= 8 * byte && hole_of[r][c] < 8 * byte + 8 && (v & (1 << (hole_of[r][c] - 8 * byte))))
+                        expand_bytes[byte][v] = set_marble(expand_bytes[byte][v], r, c);
+        }
+    int n, k;
+    for (n = 0; n <= MAX_BOARD_CT; n++)
+        for (k = 0; k <= MAX_BOARD_CT; k++)
+            binomial[n][k] = k == 0 ? 1 : n == 0 ? 0 : binomial[n-1][k-1] + binomial[n-1][k];
+}
+
+static inline unsigned long long compact_bits(const unsigned long long bits)
+{
+    unsigned long long compact = 0uLL;
+    int r;
+    for (r = 0; r < 7; r++)
+        compact |= compact_rows[r][(bits >> (42 - 7*r)) & 127];
+    return compact;
+}
+
+static inline unsigned long long expand_bits(const unsigned long long compact)
+{
+    return expand_bytes[0][compact & 255] | expand_bytes[1][(compact >> 8) & 255] | expand_bytes[2][(compact >> 16) & 255]
+         | expand_bytes[3][(compact >> 24) & 255] | expand_bytes[4][(compact >> 32) & 255]
+         | expand_bytes[5][(compact >> 40) & 255] | expand_bytes[6][(compact >> 48) & 255];
+}
+
+static inline unsigned long long rank_compact(unsigned long long compact)
+{
+    unsigned long long rank = 0;
+    int i = 1;
+    while (compact)
+    {
+        rank += binomial[__builtin_ctzll(compact)][i++];
+        compact &= compact - 1;
+    }
+    return rank;
+}
+
+unsigned long long unrank_compact(unsigned long long rank, int k)
+{
+    unsigned long long compact = 0uLL;
+    int hole = board_ct - 1;
+    for (; k > 0; k--)
+    {
+        while (binomial[hole][k] > rank)
+            hole--;
+        compact |= 1uLL << hole;
+        rank -= binomial[hole][k];
+        hole--;
+    }
+    return compact;
+}
+
+// the next arrangement with as many marbles, in rank order
+static inline unsigned long long next_compact(const unsigned long long compact)
+{
+    unsigned long long low = compact & -compact;
+    unsigned long long ripple = compact + low;
+    return (((ripple ^ compact) >> 2) / low) | ripple;
+}
+
+typedef struct {
+    int ct;                                 // marbles in the layer being built
+    int reach;                              // planes for final counts 1..reach
+    unsigned long long states;              // C(holes, ct)
+    const unsigned long long *below[TB_MAX_REACH + 1];   // finished layer ct - 1
+    unsigned long long *planes[TB_MAX_REACH + 1];        // layer being built (all bits start cleared)
+    unsigned long long next_chunk;          // shared by the threads; taken with an atomic add
+} tb_job_t;
+
+void *tb_worker(void *arg)
+{
+    tb_job_t *job = arg;
+    unsigned long long children[MAX_CHILDREN];
+    unsigned long long words[TB_MAX_REACH + 1];
+    const unsigned all = ((1u << job->reach) - 1) << 1;
+    int f, i;
+    for (;;)
+    {
+        unsigned long long start = __atomic_fetch_add(&job->next_chunk, TB_CHUNK, __ATOMIC_RELAXED);
+        if (start >= job->states)
+            break;
+        unsigned long long end = start + TB_CHUNK < job->states ? start + TB_CHUNK : job->states;
+        unsigned long long compact = unrank_compact(start, job->ct);
+        unsigned long long index;
+        memset(words, 0, sizeof words);
+        for (index = start; index < end; index++, compact = next_compact(compact))
+        {
+            // bit f of reached: a board with at most f marbles can be reached.
+            // Every final count at or above the layer's is reached already, by the board itself.
+            unsigned reached = 0;
+            for (f = job->ct; f <= job->reach; f++)
+                reached |= 1u << f;
+            if (reached != all)
+            {
+                int n = gen_children(expand_bits(compact), children);
+                for (i = 0; i < n && reached != all; i++)
+                {
+                    unsigned long long child = rank_compact(compact_bits(children[i]));
+                    for (f = 1; f <= job->reach; f++)
+                        reached |= ((job->below[f][child >> 6] >> (child & 63)) & 1) << f;
+                }
+            }
+            for (f = 1; f <= job->reach; f++)
+                words[f] |= (unsigned long long) ((reached >> f) & 1) << (index & 63);
+            if ((index & 63) == 63 || index == end - 1)
+            {
+                // no other thread writes this word (chunks are whole words), but the atomic or keeps that from mattering
+                for (f = 1; f <= job->reach; f++)
+                    if (words[f])
+                        __atomic_fetch_or(&job->planes[f][index >> 6], words[f], __ATOMIC_RELAXED);
+                memset(words, 0, sizeof words);
+            }
+        }
+    }
+    return NULL;
+}
+
+int processes_to_threads(int processes)
+{
+    if (processes > 0)
+        return processes;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int) cpus : 1;
+}
+
+void build_tablebase(const char *dir, int maxct, int reach, int threads)
+{
+    init_ranking();
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Could not create work directory \"%s\": %s\n", dir, strerror(errno));
+        exit(1);
+    }
+    tb_job_t job = { .reach = reach };
+    states_map_t belowmaps[TB_MAX_REACH + 1] = { { 0 } };
+    unsigned long long *belowowned[TB_MAX_REACH + 1] = { 0 };
+    unsigned long long ownedwords = 0;              // size of the layer below, when it is one built here
+    char path[4096];
+    int ct, f, t;
+    printf("Building tablebase layers of 1 to %d marbles (final counts 1 to %d) with %d thread%s.\n",
+           maxct, reach, threads, threads==1?"":"s");
+    for (ct = 1; ct <= maxct; ct++)
+    {
+        job.ct = ct;
+        job.states = binomial[board_ct][ct];
+        unsigned long long words = (job.states + 63) / 64;
+
+        // reuse the layer if an earlier build finished it
+        bool done = true;
+        for (f = 1; f <= reach; f++)
+        {
+            snprintf(path, sizeof path, TB_FILE_FORMAT, dir, ct, f, dirs_len > ORTHOGONAL_DIRS_LEN ? "_diagonal" : "");
+            done = done && access(path, R_OK) == 0;
+        }
+        if (done)
+        {
+            for (f = 1; f <= reach; f++)
+            {
+                snprintf(path, sizeof path, TB_FILE_FORMAT, dir, ct, f, dirs_len > ORTHOGONAL_DIRS_LEN ? "_diagonal" : "");
+                unmap_states_file(&belowmaps[f]);
+                big_free(belowowned[f], ownedwords * 8);
+                belowowned[f] = NULL;
+                belowmaps[f] = map_states_file(path, STATES_ENCODING_RANK_BITMAP);
+                if (belowmaps[f].count != job.states)
+                {
+                    fprintf(stderr, "\"%s\" does not hold %llu states.\n", path, job.states);
+                    exit(1);
+                }
+                madvise(belowmaps[f].map, belowmaps[f].maplen, MADV_RANDOM);
+                job.below[f] = belowmaps[f].states;
+            }
+            printf("Layer %2d: %llu states, reusing the layer found in \"%s\".\n", ct, job.states, dir);
+            continue;
+        }
+
+        char layername[32];
+        snprintf(layername, sizeof layername, "Layer %2d", ct);
+        for (f = 1; f <= reach; f++)
+        {
+            job.planes[f] = (unsigned long long*) big_alloc(words * sizeof *job.planes[f], f == 1 ? layername : NULL);
+            if (!job.planes[f])
+            {
+                fprintf(stderr, "Could not allocate layer %d (%llu bytes).\n", ct, words * 8);
+                exit(1);
+            }
+        }
+        job.next_chunk = 0;
+        double layerstart = now_seconds();
+        pthread_t tids[threads];
+        for (t = 0; t < threads; t++)
+            if (pthread_create(&tids[t], NULL, tb_worker, &job) != 0)
+            {
+                perror("pthread_create() failed");
+                exit(1);
+            }
+        for (t = 0; t < threads; t++)
+            pthread_join(tids[t], NULL);
+        double seconds = now_seconds() - layerstart;
+
+        printf("Layer %2d: %llu states in %.1f s (%.2f M states/s);", ct, job.states, seconds,
+               seconds > 0 ? job.states / seconds / 1e6 : 0.0);
+        for (f = 1; f <= reach; f++)
+        {
+            unsigned long long w, reached = 0;
+            for (w = 0; w < words; w++)
+                reached += __builtin_popcountll(job.planes[f][w]);
+            printf(" %llu reach %d%s", reached, f, f < reach ? "," : ".\n");
+            snprintf(path, sizeof path, TB_FILE_FORMAT, dir, ct, f, dirs_len > ORTHOGONAL_DIRS_LEN ? "_diagonal" : "");
+            write_bitmap_file(path, job.planes[f], job.states);
+
+            // this layer is the one below the next
+            unmap_states_file(&belowmaps[f]);
+            big_free(belowowned[f], ownedwords * 8);
+            belowowned[f] = job.planes[f];
+            job.below[f] = job.planes[f];
+        }
+        ownedwords = words;
+        fflush(stdout);
+    }
+    for (f = 1; f <= reach; f++)
+    {
+        unmap_states_file(&belowmaps[f]);
+        big_free(belowowned[f], ownedwords * 8);
+    }
+}
+
+
+// ===================================
+// solution chain validation
+//   --validate checks files of solution chains: text (one board state per line, chains separated by blank lines),
+//   or packed binary files (chains separated by a 0 state, which is never a board).
+//   Every step must be a single legal jump, found with the move masks; every chain must begin at the starting state
+//   (if one is given) and end on the solution condition (threshold, target state or target set).
+//   The file is memory-mapped and split into chunks at chain boundaries, validated in parallel.
+
+#define VALIDATE_MAX_REPORTED 20    // invalid chains reported, at most (each chunk keeps its first ones)
+
+typedef struct {
+    unsigned long long chain;       // chain number (within the chunk, until the chunks are put together)
+    unsigned long long position;    // line (text) or state (binary) number of the invalid state, likewise
+    int step;                       // moves from the chain's start to the invalid state
+    const char *reason;
+} validate_failure_t;
+
+typedef struct {
+    // the chunk: a range of a text file's bytes, or of a binary file's states
+    const char *text, *textend;
+    const unsigned long long *states;
+    unsigned long long count;
+    // what was found
+    unsigned long long chains, invalid, checked, lines;
+    validate_failure_t failures[VALIDATE_MAX_REPORTED];
+    int failurect;
+} validate_chunk_t;
+
+typedef struct {
+    validate_chunk_t *chunks;
+    int chunkct;
+    int next_chunk;                 // shared by the threads; taken with an atomic add
+    bool parse_dec, parse_hex;
+    unsigned long long start_bits;  // 0 if chains may start anywhere
+    unsigned long long target_bits;
+    int targetct;
+} validate_job_t;
+
+// a chain being read, one state at a time
+typedef struct {
+    unsigned long long prev;
+    int steps;
+    bool started, failed;
+} chain_reader_t;
+
+// is child the board after one legal jump from parent?
+static inline bool is_single_jump(const unsigned long long parent, const unsigned long long child)
+{
+    unsigned long long removed = parent & ~child;
+    int d;
+    if (__builtin_popcountll(removed) != 2 || __builtin_popcountll(child & ~parent) != 1)
+        return false;
+    for (d = 0; d < dirs_len; d++)
+    {
+        // the jumped marble is one of the two removed; at most two candidates in each direction
+        unsigned long long mids = removed & move_mask(parent, d);
+        while (mids)
+        {
+            unsigned long long mid = mids & -mids;
+            if (apply_move(parent, mid, d) == child)
+                return true;
+            mids ^= mid;
+        }
+    }
+    return false;
+}
+
+void validate_fail(validate_chunk_t *chunk, chain_reader_t *reader, unsigned long long position, const char *reason)
+{
+    reader->failed = true;
+    chunk->invalid++;
+    if (chunk->failurect < VALIDATE_MAX_REPORTED)
+        chunk->failures[chunk->failurect++] = (validate_failure_t){
+            .chain = chunk->chains - 1, .position = position, .step = reader->steps, .reason = reason
+        };
+}
+
+// feeds the next state of a chain (0 if the line could not be parsed as a board state)
+static inline void validate_state(const validate_job_t *job, validate_chunk_t *chunk, chain_reader_t *reader,
+                                  unsigned long long bits, unsigned long long position)
+{
+    if (!reader->started)
+    {
+        reader->started = true;
+        reader->failed = false;
+        reader->steps = 0;
+        chunk->chains++;
+        if (!bits)
+            validate_fail(chunk, reader, position, "not a board state");
+        else if (job->start_bits && bits != job->start_bits)
+            validate_fail(chunk, reader, position, "does not begin at the starting state");
+    }
+    else if (!reader->failed)
+    {
+        reader->steps++;
+        if (!bits)
+            validate_fail(chunk, reader, position, "not a board state");
+        else if (!is_single_jump(reader->prev, bits))
+            validate_fail(chunk, reader, position, "not a single legal jump from the state before");
+    }
+    reader->prev = bits;
+    chunk->checked++;
+}
+
+// at the end of a chain: does it end on the solution condition?
+static inline void validate_end(const validate_job_t *job, validate_chunk_t *chunk, chain_reader_t *reader,
+                                unsigned long long position)
+{
+    if (reader->started && !reader->failed)
+    {
+        bool solved = job->target_bits || target_set
+                      ? is_target_state(job->target_bits, reader->prev)
+                      : count_bits(reader->prev) <= job->targetct;
+        if (!solved)
+            validate_fail(chunk, reader, position, "does not end on the solution condition");
+    }
+    reader->started = false;
+}
+
+// one line of a text chain file: a board state of this board, or 0 (blank lines are not passed in)
+static unsigned long long parse_chain_state(const char *s, const char *end, bool parse_dec, bool parse_hex)
+{
+    int base = parse_dec ? 10 : parse_hex ? 16 : 2;
+    unsigned long long value = 0;
+    if (end - s >= 2 && s[0] == '0' && ((parse_hex && s[1] == 'x') || (base == 2 && s[1] == 'b')))
+    {
+        s += 2;
+        // (hex states as the solver prints them, "0x %012llx")
+        while (s < end && *s == ' ')
+            s++;
+    }
+    if (s >= end)
+        return 0;
+    if (base == 2)
+    {
+        unsigned bad = 0;
+        if (end - s > 49)
+            return 0;
+        // the common case, 49 digits: eight at a time, by subtracting '0' from each byte and gathering the low bits
+        for (; end - s >= 8; s += 8)
+        {
+            uint64_t chars;
+            memcpy(&chars, s, 8);
+            chars -= 0x3030303030303030uLL;
+            if (chars & ~0x0101010101010101uLL)
+                return 0;
+            // (little endian: the first digit is the lowest byte, and is multiplied up to the top bit)
+            value = value << 8 | (chars * 0x8040201008040201uLL) >> 56;
+        }
+        for (; s < end; s++)
+        {
+            unsigned digit = (unsigned char) *s - '0';
+            bad |= digit;
+            value = value << 1 | (digit & 1);
+        }
+        return (bad > 1 || (value & ~board_holes)) ? 0 : value;
+    }
+    for (; s < end; s++)
+    {
+        int digit = *s >= '0' && *s <= '9' ? *s - '0' : is_hex(*s) ? (*s | 32) - 'a' + 10 : base;
+        if (digit >= base)
+            return 0;
+        value = value * base + digit;
+        if (value > board_holes)
+            return 0;
+    }
+    return (value & ~board_holes) ? 0 : value;
+}
+
+void validate_text_chunk(const validate_job_t *job, validate_chunk_t *chunk)
+{
+    chain_reader_t reader = { .started = false };
+    const char *line = chunk->text;
+    while (line < chunk->textend)
+    {
+        const char *eol = memchr(line, '\n', chunk->textend - line);
+        if (!eol)
+            eol = chunk->textend;
+        const char *s = line, *e = eol;
+        while (s < e && (*s == ' ' || *s == '\t'))
+            s++;
+        while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+            e--;
+        chunk->lines++;
+        if (s == e)
+            validate_end(job, chunk, &reader, chunk->lines - 1);
+        else
+            validate_state(job, chunk, &reader, parse_chain_state(s, e, job->parse_dec, job->parse_hex), chunk->lines);
+        line = eol + 1;
+    }
+    validate_end(job, chunk, &reader, chunk->lines);
+}
+
+void validate_binary_chunk(const validate_job_t *job, validate_chunk_t *chunk)
+{
+    chain_reader_t reader = { .started = false };
+    unsigned long long i;
+    for (i = 0; i < chunk->count; i++)
+    {
+        unsigned long long bits = chunk->states[i];
+        if (!bits)
+            validate_end(job, chunk, &reader, i);
+        else
+            validate_state(job, chunk, &reader, (bits & ~board_holes) ? 0 : bits, i + 1);
+    }
+    validate_end(job, chunk, &reader, chunk->count);
+}
+
+void *validate_worker(void *arg)
+{
+    validate_job_t *job = (validate_job_t*) arg;
+    int c;
+    while ((c = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED)) < job->chunkct)
+    {
+        if (job->chunks[c].text)
+            validate_text_chunk(job, &job->chunks[c]);
+        else
+            validate_binary_chunk(job, &job->chunks[c]);
+    }
+    return NULL;
+}
+
+// validates every chain in a file; returns how many are invalid
+unsigned long long validate_chains(const char *path, unsigned long long start_bits, unsigned long long target_bits, int targetct,
+                                   bool parse_dec, bool parse_hex, int threads)
+{
+    validate_job_t job = {
+        .parse_dec = parse_dec, .parse_hex = parse_hex,
+        .start_bits = start_bits, .target_bits = target_bits, .targetct = targetct
+    };
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "Could not open \"%s\": %s\n", path, strerror(errno));
+        exit(1);
+    }
+    char magic[sizeof STATES_FILE_MAGIC - 1] = { 0 };
+    bool binary = read(fd, magic, sizeof magic) == sizeof magic && memcmp(magic, STATES_FILE_MAGIC, sizeof magic) == 0;
+    close(fd);
+
+    states_map_t map = { 0 };
+    const char *text = NULL;
+    size_t size = 0;
+    if (binary)
+    {
+        map = map_states_file(path, STATES_ENCODING_BITS);
+        size = map.count;
+    }
+    else if (st.st_size > 0)
+    {
+        fd = open(path, O_RDONLY);
+        text = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (text == MAP_FAILED)
+        {
+            fprintf(stderr, "Could not map \"%s\": %s\n", path, strerror(errno));
+            exit(1);
+        }
+        madvise((void*) text, st.st_size, MADV_SEQUENTIAL);
+        size = st.st_size;
+    }
+
+    // a few chunks per thread, so they finish together; each boundary moves forward to the start of a chain
+    job.chunkct = threads * 4;
+    job.chunks = (validate_chunk_t*) calloc(job.chunkct, sizeof *job.chunks);
+    size_t begin = 0;
+    int c;
+    for (c = 0; c < job.chunkct; c++)
+    {
+        size_t end = c + 1 == job.chunkct ? size : size / job.chunkct * (c + 1);
+        if (end < begin)
+            end = begin;
+        if (binary)
+        {
+            while (end < size && end > 0 && map.states[end-1] != 0)
+                end++;
+            job.chunks[c].states = map.states + begin;
+            job.chunks[c].count = end - begin;
+        }
+        else
+        {
+            while (end < size && end > 0 && !(text[end-1] == '\n' && (end < 2 || text[end-2] == '\n')))
+                end++;
+            job.chunks[c].text = text + begin;
+            job.chunks[c].textend = text + end;
+        }
+        begin = end;
+    }
+
+    double start = now_seconds();
+    pthread_t tids[threads];
+    int t;
+    for (t = 0; t < threads; t++)
+        if (pthread_create(&tids[t], NULL, validate_worker, &job) != 0)
+        {
+            perror("pthread_create() failed");
+            exit(1);
+        }
+    for (t = 0; t < threads; t++)
+        pthread_join(tids[t], NULL);
+    double seconds = now_seconds() - start;
+
+    // put the chunks together, numbering chains and positions through the whole file
+    unsigned long long chains = 0, invalid = 0, checked = 0, position = 0;
+    unsigned long long reported = 0;
+    int i;
+    for (c = 0; c < job.chunkct; c++)
+    {
+        validate_chunk_t *chunk = &job.chunks[c];
+        for (i = 0; i < chunk->failurect && reported < VALIDATE_MAX_REPORTED; i++, reported++)
+        {
+            validate_failure_t *failure = &chunk->failures[i];
+            printf("Chain %llu is invalid at %s %llu (move %d): %s.\n", chains + failure->chain + 1,
+                   binary ? "state" : "line", position + failure->position, failure->step, failure->reason);
+        }
+        chains += chunk->chains;
+        invalid += chunk->invalid;
+        checked += chunk->checked;
+        position += binary ? chunk->count : chunk->lines;
+    }
+    if (invalid > reported)
+        printf("(%llu more invalid chains not shown)\n", invalid - reported);
+    printf("Validated %llu chain%s (%llu states) in %.2f s (%.1f M states/s, %.0f MB/s): %llu valid, %llu invalid.\n",
+           chains, chains==1?"":"s", checked, seconds, seconds > 0 ? checked / seconds / 1e6 : 0.0,
+           seconds > 0 ? (binary ? size * 8.0 : (double) size) / seconds / 1e6 : 0.0, chains - invalid, invalid);
+
+    free(job.chunks);
+    if (binary)
+        unmap_states_file(&map);
+    else if (text)
+        munmap((void*) text, st.st_size);
+    return invalid;
+}
+
+
+// ===================================
+// all-starts survey
+//   --survey solves every start with one marble missing, in one run: the fewest marbles each can end with
+//   (proven, as the ida engine does), or with -t | --target, whether each can reach the target board.
+//   Starts that are images of one another under a symmetry of the board (one that keeps the target too) are solved once.
+//   The work is the first moves of those starts, taken by threads sharing the visited-state cache,
+//   so a board that several starts lead to is worked out once, and comes from the cache after that.
+
+#define SURVEY_UNKNOWN -1   // out of time before it was worked out
+
+typedef struct {
+    int row, col;               // the hole that starts empty
+    unsigned long long start;
+    int rep;                    // the row this start is an image of (itself if it is solved)
+    int sym;                    // the symmetry taking the rep's start to this one
+} survey_row_t;
+
+typedef struct {
+    unsigned long long bits;    // a board one move after a solved start
+    unsigned long long key;     // its canonical form (its own bits, with a target), so symmetric boards are solved once
+    int result;                 // fewest marbles reachable, or with a target: 1 if reachable, 0 if not; or SURVEY_UNKNOWN
+    unsigned long long path[MAX_CHAIN_LEN];
+    int pathlen;
+} survey_item_t;
+
+typedef struct {
+    survey_item_t *items;
+    int itemct;
+    int next_item;              // next item for a thread to take (shared, atomic)
+    unsigned long long target_bits;
+    unsigned long long checked; // (shared, atomic)
+} survey_job_t;
+
+// boards proven unable to reach the survey's target, up to the symmetries that keep the target where it is
+cache_t reach_cache;
+int reach_sym[8];
+int reach_sym_len = 1;
+
+static inline unsigned long long reach_key(const unsigned long long bits)
+{
+    unsigned long long best = bits, image;
+    int i;
+    for (i = 1; i < reach_sym_len; i++)
+        if ((image = transform_bits(bits, reach_sym[i])) < best)
+            best = image;
+    return best;
+}
+
+// can target_bits be reached from bits (which is path[depth])?
+bool reach_search(ida_ctx_t *ctx, unsigned long long bits, int ct, unsigned long long target_bits, int targetct, int depth)
+{
+    ctx->path[depth] = bits;
+    ctx->checked++;
+    if (bits == target_bits)
+    {
+        ctx->pathlen = depth + 1;
+        return true;
+    }
+    if (ct <= targetct)
+        return false;
+    if ((ctx->checked & 0xFFF) == 0 && out_of_time())
+        ctx->aborted = true;
+    if (ctx->aborted)
+        return false;
+    // the target's color parities must be these after an even number of moves, and all flipped after an odd number
+    if (dirs_len == ORTHOGONAL_DIRS_LEN && color_class(target_bits) != (color_class(bits) ^ ((ct - targetct) & 1 ? 63 : 0)))
+        return false;
+    if (final_ct_lower_bound(bits) > targetct)
+        return false;
+    unsigned long long key = reach_key(bits);
+    if (cache_get(&reach_cache, key))
+        return false;
+
+    unsigned long long children[MAX_CHILDREN];
+    int n = gen_children(bits, children);
+    int i;
+    ctx->generated += n;
+    for (i = 0; i < n; i++)
+        if (reach_search(ctx, children[i], ct - 1, target_bits, targetct, depth + 1))
+            return true;
+    if (!ctx->aborted)
+        cache_put(&reach_cache, key, 1);
+    return false;
+}
+
+void *survey_worker(void *arg)
+{
+    survey_job_t *job = (survey_job_t*) arg;
+    int i;
+    while ((i = __atomic_fetch_add(&job->next_item, 1, __ATOMIC_RELAXED)) < job->itemct)
+    {
+        survey_item_t *item = &job->items[i];
+        ida_ctx_t ctx = { .checked = 0, .generated = 0, .aborted = false };
+        if (job->target_bits)
+            item->result = reach_search(&ctx, item->bits, count_bits(item->bits), job->target_bits, count_bits(job->target_bits), 0)
+                           ? 1 : ctx.aborted ? SURVEY_UNKNOWN : 0;
+        else
+            item->result = ida_solve_exact(&ctx, item->bits);
+        if (item->result > 0)
+        {
+            memcpy(item->path, ctx.path, sizeof *ctx.path * ctx.pathlen);
+            item->pathlen = ctx.pathlen;
+        }
+        __atomic_fetch_add(&job->checked, ctx.checked, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// surveys every single-vacancy start, for the fewest marbles (target_bits 0) or the target;
+// a chain is printed for each start ending with at most targetct marbles (or on the target)
+void run_survey(unsigned long long target_bits, int targetct, int threads, int cache_mb)
+{
+    survey_row_t rows[MAX_BOARD_CT];
+    int rowct = 0, repct = 0;
+    int r, c, i, j, k;
+
+    init_symmetry();
+    init_class_bound();
+    if (target_bits)
+    {
+        cache_init(&reach_cache, cache_mb);
+        reach_sym_len = 0;
+        for (k = 0; k < sym_group_len; k++)
+            if (transform_bits(target_bits, sym_group[k]) == target_bits)
+                reach_sym[reach_sym_len++] = sym_group[k];
+    }
+    else
+        cache_init(&vcache, cache_mb);
+
+    // the starts, each matched with the first earlier one it is an image of
+    for (r = 0; r < 7; r++)
+        for (c = 0; c < 7; c++)
+            if (is_marble(board_holes, r, c))
+            {
+                survey_row_t *row = &rows[rowct];
+                *row = (survey_row_t){ .row = r, .col = c, .start = clear_marble(board_holes, r, c), .rep = rowct, .sym = 0 };
+                for (j = 0; j < rowct && row->rep == rowct; j++)
+                    for (k = 0; k < sym_group_len && rows[j].rep == j; k++)
+                        if (transform_bits(rows[j].start, sym_group[k]) == row->start
+                            && transform_bits(target_bits, sym_group[k]) == target_bits)
+                        {
+                            row->rep = j;
+                            row->sym = sym_group[k];
+                            break;
+                        }
+                repct += row->rep == rowct;
+                rowct++;
+            }
+
+    // the work: every board one move after a start that is solved, once up to symmetry
+    survey_job_t job = { .target_bits = target_bits };
+    job.items = (survey_item_t*) malloc(sizeof *job.items * repct * MAX_CHILDREN);
+    if (!job.items)
+    {
+        perror("malloc() failed");
+        exit(1);
+    }
+    for (i = 0; i < rowct; i++)
+    {
+        unsigned long long children[MAX_CHILDREN];
+        int n = rows[i].rep == i ? gen_children(rows[i].start, children) : 0;
+        for (k = 0; k < n; k++)
+        {
+            unsigned long long key = target_bits ? children[k] : canonical_bits(children[k]);
+            for (j = 0; j < job.itemct && job.items[j].key != key; j++)
+                ;
+            if (j == job.itemct)
+                job.items[job.itemct++] = (survey_item_t){ .bits = children[k], .key = key, .result = SURVEY_UNKNOWN };
+        }
+    }
+
+    printf("Surveying %d starts with one marble missing (%d up to symmetry, %d boards after their first moves)",
+           rowct, repct, job.itemct);
+    if (target_bits)
+        printf(" for the target state 0x %012llx", target_bits);
+    else
+        printf(" for the fewest marbles reachable");
+    printf(", with %d thread%s.\n", threads, threads==1?"":"s");
+    fflush(stdout);
+
+    double start = now_seconds();
+    pthread_t tids[threads];
+    int t;
+    for (t = 0; t < threads; t++)
+        if (pthread_create(&tids[t], NULL, survey_worker, &job) != 0)
+        {
+            perror("pthread_create() failed");
+            exit(1);
+        }
+    for (t = 0; t < threads; t++)
+        pthread_join(tids[t], NULL);
+    double seconds = now_seconds() - start;
+
+    // each solved start takes its best first move; its images take the same line, transformed
+    int results[MAX_BOARD_CT];
+    const survey_item_t *best[MAX_BOARD_CT];
+    int bestsym[MAX_BOARD_CT];          // the symmetry taking the best item's board to the start's own move
+    for (i = 0; i < rowct; i++)
+    {
+        unsigned long long children[MAX_CHILDREN];
+        int n, known;
+        bool unknown = false;
+        best[i] = NULL;
+        if (rows[i].rep != i)
+            continue;
+        n = gen_children(rows[i].start, children);
+        for (k = 0; k < n; k++)
+        {
+            unsigned long long key = target_bits ? children[k] : canonical_bits(children[k]);
+            for (j = 0; job.items[j].key != key; j++)
+                ;
+            const survey_item_t *item = &job.items[j];
+            if (item->result == SURVEY_UNKNOWN)
+                unknown = true;
+            else if (!best[i] || (target_bits ? item->result > best[i]->result : item->result < best[i]->result))
+            {
+                best[i] = item;
+                for (t = 0; t < sym_group_len && transform_bits(item->bits, sym_group[t]) != children[k]; t++)
+                    ;
+                bestsym[i] = sym_group[t];
+            }
+        }
+        known = best[i] ? best[i]->result : target_bits ? rows[i].start == target_bits : count_bits(rows[i].start);
+        // with some moves unsolved, only a found target or the lower bound is the final answer
+        results[i] = !unknown || (target_bits ? known == 1 : known <= final_ct_lower_bound(rows[i].start)) ? known : SURVEY_UNKNOWN;
+    }
+
+    printf("\n  hole    %-10s  image of\n", target_bits ? "target" : "fewest");
+    for (i = 0; i < rowct; i++)
+    {
+        int result = results[rows[i].rep];
+        printf("  (%d,%d)   ", rows[i].row, rows[i].col);
+        if (result == SURVEY_UNKNOWN)
+            printf("%-10s", "unknown");
+        else if (target_bits)
+            printf("%-10s", result ? "reached" : "no");
+        else
+            printf("%-10d", result);
+        if (rows[i].rep != i)
+            printf("  (%d,%d)", rows[rows[i].rep].row, rows[rows[i].rep].col);
+        putchar('\n');
+    }
+
+    printf("\nSolution chains (one per start %s):\n", target_bits ? "reaching the target" : "ending with the threshold or fewer marbles");
+    int solved = 0;
+    for (i = 0; i < rowct; i++)
+    {
+        const survey_item_t *item = best[rows[i].rep];
+        int result = results[rows[i].rep], sym = bestsym[rows[i].rep];
+        if (result == SURVEY_UNKNOWN || !item || (target_bits ? result != 1 : result > targetct))
+            continue;
+        // (a blank line between chains, as --validate reads them)
+        printf("%s(%d,%d), %d moves:\n", solved ? "\n" : "", rows[i].row, rows[i].col, item->pathlen);
+        printf("  0x %012llx\n", rows[i].start);
+        for (k = 0; k < item->pathlen; k++)
+            printf("  0x %012llx\n", transform_bits(transform_bits(item->path[k], sym), rows[i].sym));
+        solved++;
+    }
+    if (!solved)
+        printf("(none)\n");
+    printf("\nInfo: Survey finished in %.2f s: checked %llu states; %d of %d starts solved.\n",
+           seconds, job.checked, solved, rowct);
+    free(job.items);
+}
+
+
+// ===================================
+// kernel microbenchmarks
+//   --bench times the inner kernels of the search on their own, over a fixed corpus of random legal boards
+//   (reached by random play from a single-vacancy start, with a fixed seed) at several marble counts.
+//   Each kernel is run over the corpus until BENCH_SECONDS have passed. On Linux, hardware counters
+//   (cycles, instructions, branch misses, cache misses) are read through perf_event_open;
+//   where that is not allowed (or not Linux), only the time is reported.
+
+#define BENCH_SEED 0x5EED5EED5EED5EEDuLL
+#define BENCH_BOARDS 4096               // boards of each marble count
+#define BENCH_SECONDS 0.25              // minimum time each kernel runs, at each marble count
+#define BENCH_COUNTERS 4
+
+const int BENCH_MARBLE_CTS[] = {32, 24, 16, 8};
+const int BENCH_MARBLE_CTS_LEN = 4;
+const char *BENCH_COUNTER_NAMES[] = {"cycles", "instructions", "branch misses", "cache misses"};
+
+typedef struct {
+    unsigned long long boards[BENCH_BOARDS];
+    unsigned long long keys[BENCH_BOARDS];      // canonical forms, for the cache probe
+    unsigned long long targets[BENCH_BOARDS];   // a dead end reached from each board, for the target search
+    char texts[BENCH_BOARDS][50];               // boards written as binary board states, for parsing
+} bench_corpus_t;
+
+typedef struct {
+    const char *name;
+    int calls_per_board;
+    unsigned long long (*run)(const bench_corpus_t *corpus);    // runs the kernel over every board; returns a checksum
+    int max_ct;                 // only run on boards of up to this many marbles (0: any)
+} bench_kernel_t;
+
+// whole searches are only timed on small boards
+#define BENCH_DFS_MAX_CT 8
+
+typedef struct {
+    int fds[BENCH_COUNTERS];    // -1 if that counter could not be opened
+    int opened;
+} bench_counters_t;
+
+unsigned long long bench_attempt_move(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i, r, c, d;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        for (d = 0; d < dirs_len; d++)
+            for (r = 0; r < 7; r++)
+                for (c = 0; c < 7; c++)
+                    sum += attempt_move(corpus->boards[i], r, c, DIRS[d]);
+    return sum;
+}
+
+// every child of each board, taken one at a time as the dfs engine takes them (with its move ordering)
+unsigned long long bench_next_child(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0, generated = 0, child;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+    {
+        sarr[0] = (state_t){ .bits = corpus->boards[i], .ct = count_bits(corpus->boards[i]), .pindex = -1, .visited = false };
+        sarrlen = 1;
+        start_moves(0);
+        while ((child = next_child(0, &generated)))
+            sum += child;
+    }
+    return sum + generated;
+}
+
+unsigned long long bench_gen_children(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0, children[MAX_CHILDREN];
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += gen_children(corpus->boards[i], children) + children[0];
+    return sum;
+}
+
+// a whole depth first search from each board, either to a threshold of 1 marble or to the board's target
+unsigned long long bench_dfs(const bench_corpus_t *corpus, bool target)
+{
+    unsigned long long sum = 0, checked = 0, generated = 0;
+    int i;
+    quiet_search = true;
+    for (i = 0; i < BENCH_BOARDS; i++)
+    {
+        sarr[0] = (state_t){ .bits = corpus->boards[i], .ct = count_bits(corpus->boards[i]), .pindex = -1, .visited = false };
+        sarrlen = 1;
+        sum += target ? solve_dfs(corpus->targets[i], count_bits(corpus->targets[i]), &checked, &generated)
+                      : solve_dfs(0uLL, 1, &checked, &generated);
+    }
+    quiet_search = false;
+    return sum + checked;
+}
+
+unsigned long long bench_dfs_count(const bench_corpus_t *corpus)
+{
+    return bench_dfs(corpus, false);
+}
+
+unsigned long long bench_dfs_target(const bench_corpus_t *corpus)
+{
+    return bench_dfs(corpus, true);
+}
+
+unsigned long long bench_count_moves(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += count_moves(corpus->boards[i]);
+    return sum;
+}
+
+unsigned long long bench_count_bits(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += count_bits(corpus->boards[i]);
+    return sum;
+}
+
+unsigned long long bench_canonical_bits(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += canonical_bits(corpus->boards[i]);
+    return sum;
+}
+
+unsigned long long bench_cache_probe(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += cache_get(&vcache, corpus->keys[i]);
+    return sum;
+}
+
+// the same probes, in a cache on plain pages (from calloc()), to compare with the huge pages of vcache
+cache_t bench_plain_cache;
+
+unsigned long long bench_plain_cache_probe(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += cache_get(&bench_plain_cache, corpus->keys[i]);
+    return sum;
+}
+
+unsigned long long bench_parse_board_state(const bench_corpus_t *corpus)
+{
+    unsigned long long sum = 0;
+    int i;
+    for (i = 0; i < BENCH_BOARDS; i++)
+        sum += read_board_state((char*) corpus->texts[i], false, false, stderr);
+    return sum;
+}
+
+const bench_kernel_t BENCH_KERNELS[] = {
+    {"attempt_move", 4 * 49, bench_attempt_move, 0},
+    {"next_child (all)", 1, bench_next_child, 0},
+    {"gen_children", 1, bench_gen_children, 0},
+    {"count_moves", 1, bench_count_moves, 0},
+    {"count_bits", 1, bench_count_bits, 0},
+    {"canonical_bits", 1, bench_canonical_bits, 0},
+    {"cache_get", 1, bench_cache_probe, 0},
+    {"cache_get (4 kB pages)", 1, bench_plain_cache_probe, 0},
+    {"parse_board_state", 1, bench_parse_board_state, 0},
+    {"solve_dfs (count)", 1, bench_dfs_count, BENCH_DFS_MAX_CT},
+    {"solve_dfs (target)", 1, bench_dfs_target, BENCH_DFS_MAX_CT},
+};
+const int BENCH_KERNELS_LEN = 11;
+
+// fills the corpus with random boards of ct marbles, each reached by random play from a random single-vacancy start
+void bench_make_corpus(bench_corpus_t *corpus, int ct)
+{
+    unsigned long long children[MAX_CHILDREN];
+    int i, j;
+    for (i = 0; i < BENCH_BOARDS; i++)
+    {
+        unsigned long long bits;
+        do {
+            int vacancy = (int) (rng_next() % board_ct);
+            bits = board_holes;
+            for (j = 48; j >= 0; j--)
+                if ((board_holes & (1uLL << j)) && vacancy-- == 0)
+                    bits &= ~(1uLL << j);
+            while (count_bits(bits) > ct)
+            {
+                int n = gen_children(bits, children);
+                if (n == 0)
+                    break;
+                bits = children[rng_next() % n];
+            }
+        } while (count_bits(bits) != ct);   // stuck before reaching ct marbles; play another game
+        corpus->boards[i] = bits;
+        corpus->keys[i] = canonical_bits(bits);
+        for (j = 0; j < 49; j++)
+            corpus->texts[i][j] = bits & (1uLL << (48 - j)) ? '1' : '0';
+        corpus->texts[i][49] = '\0';
+        // (always the first move, so the corpus's random boards stay the same)
+        while (gen_children(bits, children))
+            bits = children[0];
+        corpus->targets[i] = bits;
+    }
+}
+
+#ifdef __linux__
+static long perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd, unsigned long flags)
+{
+    return syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+#endif
+
+// opens the hardware counters of this thread as one group; returns how many could be opened
+int bench_open_counters(bench_counters_t *counters)
+{
+    int i;
+    counters->opened = 0;
+    for (i = 0; i < BENCH_COUNTERS; i++)
+        counters->fds[i] = -1;
+#ifdef __linux__
+    const unsigned long long configs[BENCH_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (i = 0; i < BENCH_COUNTERS; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = counters->opened == 0;  // the group leader starts and stops them all
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        counters->fds[i] = (int) perf_event_open(&attr, 0, -1, counters->opened ? counters->fds[0] : -1, 0);
+        if (counters->fds[i] >= 0)
+            counters->opened++;
+        else if (i == 0)
+            break;              // no cycles counter to lead the group; go without counters
+    }
+#endif
+    return counters->opened;
+}
+
+void bench_start_counters(const bench_counters_t *counters)
+{
+#ifdef __linux__
+    if (counters->opened)
+    {
+        ioctl(counters->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+// stops the counters, and reads them into values (in BENCH_COUNTER_NAMES order, 0 for any not opened)
+void bench_stop_counters(const bench_counters_t *counters, unsigned long long *values)
+{
+    int i;
+    memset(values, 0, sizeof *values * BENCH_COUNTERS);
+#ifdef __linux__
+    if (counters->opened)
+    {
+        unsigned long long group[1 + BENCH_COUNTERS];   // the number of counters, then each one's value
+        int k = 1;
+        ioctl(counters->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        if (read(counters->fds[0], group, sizeof group) < (ssize_t) sizeof *group)
+            return;
+        for (i = 0; i < BENCH_COUNTERS && k <= (int) group[0]; i++)
+            if (counters->fds[i] >= 0)
+                values[i] = group[k++];
+    }
+#endif
+}
+
+void run_benchmarks(int cache_mb)
+{
+    static bench_corpus_t corpus;
+    bench_counters_t counters;
+    unsigned long long values[BENCH_COUNTERS];
+    int m, k, i;
+
+    init_symmetry();
+    cache_init(&vcache, cache_mb);
+    bench_plain_cache.mask = vcache.mask;
+    bench_plain_cache.table = (unsigned long long*) calloc(vcache.mask + 1, sizeof *vcache.table);
+    if (!bench_plain_cache.table)
+    {
+        perror("calloc() failed");
+        exit(1);
+    }
+    // both caches touched all through, so every probe reads a page of its own table (not the shared zero page)
+    memset(bench_plain_cache.table, 0, (vcache.mask + 1) * sizeof *vcache.table);
+    prefault(vcache.table, (vcache.mask + 1) * sizeof *vcache.table, prefault_threads);
+    rng_state = BENCH_SEED;
+    if (bench_open_counters(&counters))
+    {
+        const char *separator = "";
+        printf("Hardware counters: ");
+        for (i = 0; i < BENCH_COUNTERS; i++)
+            if (counters.fds[i] >= 0)
+            {
+                printf("%s%s", separator, BENCH_COUNTER_NAMES[i]);
+                separator = ", ";
+            }
+        printf(" (per call, user space only; 0 if not available).\n");
+    }
+    else
+        printf("Hardware counters are not available here (perf_event_open failed); timing only.\n");
+
+    for (m = 0; m < BENCH_MARBLE_CTS_LEN; m++)
+    {
+        bench_make_corpus(&corpus, BENCH_MARBLE_CTS[m]);
+        // half of the boards are in the cache, so half the probes hit
+        for (i = 0; i < BENCH_BOARDS; i += 2)
+        {
+            cache_put(&vcache, corpus.keys[i], 1);
+            cache_put(&bench_plain_cache, corpus.keys[i], 1);
+        }
+        printf("\n%d marbles (%d boards):\n", BENCH_MARBLE_CTS[m], BENCH_BOARDS);
+        printf("  %-22s %10s", "kernel", "ns/call");
+        if (counters.opened)
+            printf(" %10s %10s %6s %10s %10s", "cycles", "instr", "IPC", "br-miss", "cache-miss");
+        putchar('\n');
+        for (k = 0; k < BENCH_KERNELS_LEN; k++)
+        {
+            const bench_kernel_t *kernel = &BENCH_KERNELS[k];
+            if (kernel->max_ct && BENCH_MARBLE_CTS[m] > kernel->max_ct)
+                continue;
+            volatile unsigned long long sink = kernel->run(&corpus);    // warm up
+            unsigned long long passes = 0;
+            double start = now_seconds(), seconds;
+            bench_start_counters(&counters);
+            do {
+                sink += kernel->run(&corpus);
+                passes++;
+            } while ((seconds = now_seconds() - start) < BENCH_SECONDS);
+            bench_stop_counters(&counters, values);
+            (void) sink;
+
+            double calls = (double) passes * BENCH_BOARDS * kernel->calls_per_board;
+            printf("  %-22s %10.2f", kernel->name, seconds * 1e9 / calls);
+            if (counters.opened)
+                printf(" %10.1f %10.1f %6.2f %10.3f %10.3f", values[0] / calls, values[1] / calls,
+                       values[0] ? (double) values[1] / values[0] : 0.0, values[2] / calls, values[3] / calls);
+            putchar('\n');
+        }
+        fflush(stdout);
+    }
+    for (i = 0; i < BENCH_COUNTERS; i++)
+        if (counters.fds[i] >= 0)
+            close(counters.fds[i]);
+}
+
+
+// ===================================
+// interactive play
+//   A prompt for playing a game out by hand, with the ida engine at hand to say how good each move is.
+//   The visited-state cache lives as long as the session, and every line the engine finds is cached
+//   as exact, so after a hint or an analysis, the next move's answers mostly come straight from the cache.
+//   analyze solves the children of the current board in parallel, sharing the one cache.
+
+#define REPL_LINE_LEN 4096
+
+const char *REPL_HELP = "Commands:\n"
+    "  load <board-state>         start over from a board state (in the -d or -x format, if given)\n"
+    "  show                       print the board and its moves, numbered\n"
+    "  move <n>                   make move number n of show\n"
+    "  move <row> <col> <dir>     jump the marble at row, col (counting from 0) left, right, up or down\n"
+    "                             (or up-left, up-right, down-left or down-right, with --diagonal)\n"
+    "  undo                       take back the last move\n"
+    "  hint                       suggest a best move\n"
+    "  best                       the fewest marbles reachable, and a line of moves reaching it\n"
+    "  analyze                    every move, with the fewest marbles reachable after it\n"
+    "  help                       show this list\n"
+    "  quit                       leave\n";
+
+const char *DIR_NAMES[] = {"", "left", "right", "up", "down", "up-left", "up-right", "down-left", "down-right"};
+
+typedef struct {
+    unsigned long long bits;    // the board after the move
+    int row, col;               // the marble that jumps
+    int dir;
+} play_move_t;
+
+// writes every move of a board into moves, in the order gen_children() makes them; returns how many there are
+int list_moves(unsigned long long bits, play_move_t *moves)
+{
+    int r, c, d, roff, coff;
+    int n = 0;
+    unsigned long long newbits;
+    for (d = 0; d < dirs_len; d++)
+        for (r = 0; r < 7; r++)
+            for (c = 0; c < 7; c++)
+                if ((newbits = attempt_move(bits, r, c, DIRS[d])))
+                {
+                    dir_offsets(DIRS[d], &roff, &coff);
+                    moves[n++] = (play_move_t){ .bits = newbits, .row = r - roff, .col = c - coff, .dir = DIRS[d] };
+                }
+    return n;
+}
+
+void print_play_board(unsigned long long bits)
+{
+    int r, c;
+    printf("     0 1 2 3 4 5 6\n");
+    for (r = 0; r < 7; r++)
+    {
+        printf("  %d ", r);
+        for (c = 0; c < 7; c++)
+            printf(" %c", !is_marble(board_holes, r, c) ? ' ' : is_marble(bits, r, c) ? 'o' : '.');
+        putchar('\n');
+    }
+    printf("  %d marble%s (base16: 0x %012llx)\n", count_bits(bits), count_bits(bits)==1?"":"s", bits);
+}
+
+void print_play_move(int index, const play_move_t *move)
+{
+    printf("  %2d. %d %d %-*s", index + 1, move->row, move->col, dirs_len > ORTHOGONAL_DIRS_LEN ? 10 : 5, DIR_NAMES[move->dir]);
+}
+
+typedef struct {
+    const play_move_t *moves;
+    int *results;               // fewest marbles reachable after each move, or -1 if out of time
+    int n;
+    int next_move;              // next move for a thread to take (shared, atomic)
+    unsigned long long checked; // (shared, atomic)
+} analyze_job_t;
+
+void *analyze_worker(void *arg)
+{
+    analyze_job_t *job = (analyze_job_t*) arg;
+    int i;
+    while ((i = __atomic_fetch_add(&job->next_move, 1, __ATOMIC_RELAXED)) < job->n)
+    {
+        ida_ctx_t ctx = { .checked = 0, .generated = 0, .aborted = false };
+        job->results[i] = ida_solve_exact(&ctx, job->moves[i].bits);
+        __atomic_fetch_add(&job->checked, ctx.checked, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// each command gets the whole time limit to itself
+void start_command_clock(int time_limit)
+{
+    __atomic_store_n(&timed_out, false, __ATOMIC_RELAXED);
+    search_deadline = time_limit ? now_seconds() + time_limit : 0;
+}
+
+void print_command_stats(unsigned long long checked, double start)
+{
+    printf("(checked %llu states in %.2f s)\n", checked, now_seconds() - start);
+}
+
+// parses a whole number from a command, or returns -1
+int read_play_int(const char *arg)
+{
+    char *end;
+    long value;
+    if (!arg)
+        return -1;
+    value = strtol(arg, &end, 10);
+    return (*end || end == arg || value < 0 || value > INT_MAX) ? -1 : (int) value;
+}
+
+void run_interactive(unsigned long long startbits, bool parse_dec, bool parse_hex, int time_limit, int threads)
+{
+    unsigned long long history[MAX_CHAIN_LEN];
+    int historylen = 0;
+    play_move_t moves[MAX_CHILDREN];
+    int results[MAX_CHILDREN];
+    char line[REPL_LINE_LEN];
+    int n, i;
+
+    if (startbits)
+        history[historylen++] = startbits;
+    printf("Interactive play (ida engine, %d thread%s for analyze). Type help for the commands.\n", threads, threads==1?"":"s");
+    if (historylen)
+        print_play_board(startbits);
+    for (;;)
+    {
+        printf("> ");
+        fflush(stdout);
+        if (!fgets(line, sizeof line, stdin))
+            break;
+        char *command = strtok(line, " \t\r\n");
+        char *args[3];
+        for (i = 0; i < 3; i++)
+            args[i] = strtok(NULL, " \t\r\n");
+        if (!command)
+            continue;
+        if (strcmp(command, "quit") == 0 || strcmp(command, "exit") == 0)
+            break;
+        if (strcmp(command, "help") == 0)
+        {
+            fputs(REPL_HELP, stdout);
+            continue;
+        }
+        if (strcmp(command, "load") == 0)
+        {
+            unsigned long long bits = args[0] ? read_board_state(args[0], parse_dec, parse_hex, stdout) : 0;
+            if (!args[0])
+                printf("load must be followed by a board state. See --help board-state for the formats.\n");
+            if (!bits)
+                continue;
+            historylen = 0;
+            history[historylen++] = bits;
+            print_play_board(bits);
+            continue;
+        }
+        if (!historylen)
+        {
+            printf("No board yet; load one first (or give one on the command line).\n");
+            continue;
+        }
+
+        unsigned long long bits = history[historylen-1];
+        n = list_moves(bits, moves);
+        if (strcmp(command, "show") == 0)
+        {
+            print_play_board(bits);
+            if (n == 0)
+                printf("No moves left.\n");
+            for (i = 0; i < n; i++)
+            {
+                print_play_move(i, &moves[i]);
+                putchar('\n');
+            }
+        }
+        else if (strcmp(command, "move") == 0)
+        {
+            int choice = -1;
+            if (args[0] && !args[1])
+                choice = read_play_int(args[0]) - 1;
+            else if (args[2])
+            {
+                int row = read_play_int(args[0]), col = read_play_int(args[1]);
+                for (i = 0; i < n; i++)
+                    if (moves[i].row == row && moves[i].col == col && strcmp(DIR_NAMES[moves[i].dir], args[2]) == 0)
+                        choice = i;
+            }
+            if (choice < 0 || choice >= n)
+            {
+                printf("Not a legal move; see show for the moves of this board.\n");
+                continue;
+            }
+            history[historylen++] = moves[choice].bits;
+            print_play_board(moves[choice].bits);
+        }
+        else if (strcmp(command, "undo") == 0)
+        {
+            if (historylen <= 1)
+            {
+                printf("Nothing to undo.\n");
+                continue;
+            }
+            historylen--;
+            print_play_board(history[historylen-1]);
+        }
+        else if (strcmp(command, "hint") == 0 || strcmp(command, "best") == 0)
+        {
+            ida_ctx_t ctx = { .checked = 0, .generated = 0, .aborted = false };
+            double start = now_seconds();
+            start_command_clock(time_limit);
+            int best = ida_solve_exact(&ctx, bits);
+            if (best < 0)
+            {
+                printf("Ran out of time (--time-limit) before proving the best result.\n");
+                print_command_stats(ctx.checked, start);
+                continue;
+            }
+            if (ctx.pathlen <= 1)
+                printf("No moves left; %d marble%s remain.\n", best, best==1?"":"s");
+            else
+                printf("At best, %d marble%s can remain, in %d more move%s:\n",
+                       best, best==1?"":"s", ctx.pathlen - 1, ctx.pathlen==2?"":"s");
+            int step;
+            for (step = 0; step + 1 < ctx.pathlen; step++)
+            {
+                play_move_t stepmoves[MAX_CHILDREN];
+                int stepn = list_moves(ctx.path[step], stepmoves);
+                for (i = 0; i < stepn && stepmoves[i].bits != ctx.path[step+1]; i++)
+                    ;
+                // a hint is numbered as show numbers it; a line is numbered by step
+                if (strcmp(command, "hint") == 0)
+                {
+                    print_play_move(i, &stepmoves[i]);
+                    putchar('\n');
+                    break;
+                }
+                print_play_move(step, &stepmoves[i]);
+                putchar('\n');
+            }
+            print_command_stats(ctx.checked, start);
+        }
+        else if (strcmp(command, "analyze") == 0)
+        {
+            analyze_job_t job = { .moves = moves, .results = results, .n = n, .next_move = 0, .checked = 0 };
+            double start = now_seconds();
+            int t, order[MAX_CHILDREN], j;
+            if (n == 0)
+            {
+                printf("No moves left.\n");
+                continue;
+            }
+            start_command_clock(time_limit);
+            pthread_t tids[threads];
+            for (t = 0; t < threads; t++)
+                if (pthread_create(&tids[t], NULL, analyze_worker, &job) != 0)
+                {
+                    perror("pthread_create() failed");
+                    exit(1);
+                }
+            for (t = 0; t < threads; t++)
+                pthread_join(tids[t], NULL);
+
+            // best moves first; unsolved ones last
+            for (i = 0; i < n; i++)
+            {
+                int key = results[i] < 0 ? INT_MAX : results[i];
+                for (j = i; j > 0 && (results[order[j-1]] < 0 ? INT_MAX : results[order[j-1]]) > key; j--)
+                    order[j] = order[j-1];
+                order[j] = i;
+            }
+            for (i = 0; i < n; i++)
+            {
+                print_play_move(order[i], &moves[order[i]]);
+                if (results[order[i]] < 0)
+                    printf("  ? (out of time)\n");
+                else
+                    printf("  %d marble%s at best%s\n", results[order[i]], results[order[i]]==1?"":"s",
+                           results[order[i]] == results[order[0]] ? "  (best)" : "");
+            }
+            print_command_stats(job.checked, start);
+        }
+        else
+            printf("Unknown command \"%s\". Type help for the commands.\n", command);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    // printf("Hello world\n");
+    
+    // ================================
+    // perform argument parsing
+    unsigned long long arg_start_bits = 0uLL, arg_target_bits = 0uLL;
+    bool arg_parse_boardstate_hex = false, arg_parse_boardstate_decimal = false;
+    int arg_target_count = 0;
+    int arg_time_limit = 0;
+    int arg_nmcs_level = DEFAULT_NMCS_LEVEL;
+    int arg_beam_width = DEFAULT_BEAM_WIDTH;
+    int arg_cache_mb = DEFAULT_CACHE_MB;
+    int arg_split_depth = -1, arg_shards = 1;
+    int arg_processes = 1, arg_tablebase_ct = 0, arg_reach = 1;
+    int arg_shard_index = -1, arg_shard_count = 0;
+    bool arg_merge = false;
+    bool arg_interactive = false;
+    bool arg_bench = false;
+    bool arg_survey = false;
+    char *arg_board_name = NULL;
+    init_geometry(FULL_BOARD_BITS, false);
+    char *arg_work_dir = NULL;
+    char *arg_targets_path = NULL;
+    char *arg_validate_path = NULL;
+    char *arg_profile_path = NULL;
+    char *arg_convert_from = NULL, *arg_convert_to = NULL;
+    bool arg_convert_to_binary = false, arg_sort = false;
+    {
+        bool flags_encountered = false;
+        bool target_bits_encountered = false;
+        int i;
+        char *arg;
+        int argstrlen;
+        for (i = 1; i < argc; i++)
+        {
+            arg = argv[i];
+            argstrlen = strlen(arg);
+            // printf("debug: argument received: \"%s\"\n", arg);
             if (argstrlen <= 0)
                 continue;
             // printf("%d %d", strlen("-h"), strncmp(arg,"-h",strlen("-h")));
@@ -612,62 +4371,354 @@ int main(int argc, char **argv)
                 struct _flags_help flag_help;
                 for (j = 0; j < FLAGS_HELP_LEN; j++)
                 {
-                    flag_help = FLAGS_HELP[j];
-                    fprintf(stdout, "%s\n\tusage: %s\n\t%s\n", flag_help.flags, flag_help.usage, flag_help.short_desc);
+                    flag_help = FLAGS_HELP[j];
+                    fprintf(stdout, "%s\n\tusage: %s\n\t%s\n", flag_help.flags, flag_help.usage, flag_help.short_desc);
+                }
+                exit(0);
+            }
+            else if (strcmp(arg,"-t") == 0 || strcmp(arg,"--target") == 0)
+            {
+                flags_encountered = true;
+                target_bits_encountered = true;
+                i++;
+                if (i < argc && !arg_target_bits)
+                {
+                    arg = argv[i];
+                    // parse board state
+                    arg_target_bits = parse_board_state(arg, arg_parse_boardstate_decimal, arg_parse_boardstate_hex);
+                }
+                if (i >= argc)
+                {
+                    fputs("Target flag (-t | --target) must be followed by a board state. See --help for board state formatting."
+                            " Usage: [-t <board-state>]\n", stderr);
+                    exit(1);
+                }
+                if(arg_target_count)
+                {
+                    // intentionally put duplicate flag check after parsing, to provide parsing problem feedback first.
+                    fputs("Cannot specify both a target board state (-t | --target) and a marble count threshold (-c | --count)!\n", stderr);
+                    exit(1);
+                }
+            }
+            else if (strcmp(arg,"-c") == 0 || strcmp(arg,"--count") == 0)
+            {
+                flags_encountered = true;
+                i++;
+                if (i < argc && !arg_target_count)
+                {
+                    arg = argv[i];
+                    // parse number for count
+                    arg_target_count = parse_int(arg);
+                    if (arg_target_count < 1)
+                    {
+                        fputs("Target count threshold for marbles remaining must be greater than or equal to 1.\n", stderr);
+                        exit(1);
+                    }
+                }
+                if (i >= argc)
+                {
+                    fputs("Count threshold (-c | --count) must be followed by a number 1 or higher. See --help for board state formatting."
+                            " Usage: [-c <threshold>]\n", stderr);
+                    exit(1);
+                }
+                if(arg_target_bits)
+                {
+                    // intentionally put duplicate flag check after parsing, to provide parsing problem feedback first.
+                    fputs("Cannot specify both a target board state (-t | --target) and a marble count threshold (-c | --count)!\n", stderr);
+                    exit(1);
+                }
+            }
+            else if (strcmp(arg,"-o") == 0 || strcmp(arg,"--order") == 0)
+            {
+                flags_encountered = true;
+                i++;
+                if (i >= argc)
+                {
+                    fputs("Move ordering (-o | --order) must be followed by a heuristic name."
+                            " Usage: [-o (none | center | mobility | history)]\n", stderr);
+                    exit(1);
+                }
+                arg = argv[i];
+                if (strcmp(arg, "none") == 0)
+                    move_order = ORDER_NONE;
+                else if (strcmp(arg, "center") == 0)
+                    move_order = ORDER_CENTER;
+                else if (strcmp(arg, "mobility") == 0)
+                    move_order = ORDER_MOBILITY;
+                else if (strcmp(arg, "history") == 0)
+                    move_order = ORDER_HISTORY;
+                else
+                {
+                    fprintf(stderr, "Unknown move ordering heuristic \"%s\". See --help -o for the choices.\n", arg);
+                    exit(1);
+                }
+            }
+            else if (strcmp(arg,"--engine") == 0)
+            {
+                flags_encountered = true;
+                i++;
+                if (i >= argc)
+                {
+                    fputs("Engine (--engine) must be followed by an engine name."
+                            " Usage: [--engine (dfs | nmcs | beam | ida)]\n", stderr);
+                    exit(1);
+                }
+                arg = argv[i];
+                if (strcmp(arg, "dfs") == 0)
+                    search_engine = ENGINE_DFS;
+                else if (strcmp(arg, "nmcs") == 0)
+                    search_engine = ENGINE_NMCS;
+                else if (strcmp(arg, "beam") == 0)
+                    search_engine = ENGINE_BEAM;
+                else if (strcmp(arg, "ida") == 0)
+                    search_engine = ENGINE_IDA;
+                else
+                {
+                    fprintf(stderr, "Unknown search engine \"%s\". See --help --engine for the choices.\n", arg);
+                    exit(1);
                 }
-                exit(0);
             }
-            else if (strcmp(arg,"-t") == 0 || strcmp(arg,"--target") == 0)
+            else if (strcmp(arg,"--shard") == 0)
             {
                 flags_encountered = true;
-                target_bits_encountered = true;
                 i++;
-                if (i < argc && !arg_target_bits)
+                char extra;
+                if (i >= argc || sscanf(argv[i], "%d/%d%c", &arg_shard_index, &arg_shard_count, &extra) != 2
+                    || arg_shard_count < 1 || arg_shard_index < 0 || arg_shard_index >= arg_shard_count)
                 {
-                    arg = argv[i];
-                    // parse board state
-                    arg_target_bits = parse_board_state(arg, arg_parse_boardstate_decimal, arg_parse_boardstate_hex);
+                    fputs("Shard (--shard) must be followed by a shard index and count, with 0 <= index < count."
+                            " Usage: [--shard <index>/<count>]\n", stderr);
+                    exit(1);
+                }
+            }
+            else if (strcmp(arg,"--targets") == 0)
+            {
+                flags_encountered = true;
+                i++;
+                if (i >= argc)
+                {
+                    fputs("Targets (--targets) must be followed by a packed binary file. Usage: [--targets <binary-file>]\n", stderr);
+                    exit(1);
                 }
+                arg_targets_path = argv[i];
+            }
+            else if (strcmp(arg,"--huge-pages") == 0)
+            {
+                flags_encountered = true;
+                i++;
                 if (i >= argc)
                 {
-                    fputs("Target flag (-t | --target) must be followed by a board state. See --help for board state formatting."
-                            " Usage: [-t <board-state>]\n", stderr);
+                    fputs("Huge pages (--huge-pages) must be followed by a choice. Usage: [--huge-pages (off | on | prefault)]\n", stderr);
                     exit(1);
                 }
-                if(arg_target_count)
+                arg = argv[i];
+                if (strcmp(arg, "off") == 0)
+                    huge_pages = HUGE_PAGES_OFF;
+                else if (strcmp(arg, "on") == 0)
+                    huge_pages = HUGE_PAGES_ON;
+                else if (strcmp(arg, "prefault") == 0)
+                    huge_pages = HUGE_PAGES_PREFAULT;
+                else
                 {
-                    // intentionally put duplicate flag check after parsing, to provide parsing problem feedback first.
-                    fputs("Cannot specify both a target board state (-t | --target) and a marble count threshold (-c | --count)!\n", stderr);
+                    fprintf(stderr, "Unknown huge pages choice \"%s\". See --help --huge-pages for the choices.\n", arg);
                     exit(1);
                 }
             }
-            else if (strcmp(arg,"-c") == 0 || strcmp(arg,"--count") == 0)
+            else if (strcmp(arg,"--profile") == 0)
             {
                 flags_encountered = true;
                 i++;
-                if (i < argc && !arg_target_count)
+                if (i >= argc)
                 {
-                    arg = argv[i];
-                    // parse number for count
-                    arg_target_count = parse_int(arg);
-                    if (arg_target_count < 1)
+                    fputs("Profile (--profile) must be followed by a file to write. Usage: [--profile <csv-file>]\n", stderr);
+                    exit(1);
+                }
+                arg_profile_path = argv[i];
+            }
+            else if (strcmp(arg,"--validate") == 0)
+            {
+                flags_encountered = true;
+                i++;
+                if (i >= argc)
+                {
+                    fputs("Validate (--validate) must be followed by a chain file. Usage: [--validate <chain-file>]\n", stderr);
+                    exit(1);
+                }
+                arg_validate_path = argv[i];
+            }
+            else if (strcmp(arg,"--to-binary") == 0 || strcmp(arg,"--to-text") == 0)
+            {
+                flags_encountered = true;
+                if (i + 2 >= argc)
+                {
+                    fprintf(stderr, "%s must be followed by an input file and an output file. See --help %s for its usage.\n", arg, arg);
+                    exit(1);
+                }
+                arg_convert_to_binary = strcmp(arg,"--to-binary") == 0;
+                arg_convert_from = argv[++i];
+                arg_convert_to = argv[++i];
+            }
+            else if (strcmp(arg,"--sort") == 0)
+            {
+                flags_encountered = true;
+                arg_sort = true;
+            }
+            else if (strcmp(arg,"-i") == 0 || strcmp(arg,"--interactive") == 0)
+            {
+                flags_encountered = true;
+                arg_interactive = true;
+            }
+            else if (strcmp(arg,"--board") == 0 || strcmp(arg,"--diagonal") == 0)
+            {
+                flags_encountered = true;
+                if (arg_start_bits || arg_target_bits)
+                {
+                    fputs("The board (--board, --diagonal) must be chosen before any board state is given!\n", stderr);
+                    exit(1);
+                }
+                if (strcmp(arg,"--diagonal") == 0)
+                    init_geometry(board_holes, true);
+                else
+                {
+                    i++;
+                    if (i >= argc)
                     {
-                        fputs("Target count threshold for marbles remaining must be greater than or equal to 1.\n", stderr);
+                        fputs("Board (--board) must be followed by a board name or mask file."
+                                " Usage: [--board (french | english | <mask-file>)]\n", stderr);
                         exit(1);
                     }
+                    arg_board_name = argv[i];
+                    unsigned long long holes = strcmp(arg_board_name, "french") == 0 ? FULL_BOARD_BITS
+                                             : strcmp(arg_board_name, "english") == 0 ? ENGLISH_BOARD_BITS
+                                             : read_board_file(arg_board_name);
+                    init_geometry(holes, dirs_len > ORTHOGONAL_DIRS_LEN);
                 }
+            }
+            else if (strcmp(arg,"--exhaustive") == 0)
+            {
+                flags_encountered = true;
+                exhaustive_search = true;
+            }
+            else if (strcmp(arg,"--bench") == 0)
+            {
+                flags_encountered = true;
+                arg_bench = true;
+            }
+            else if (strcmp(arg,"--survey") == 0)
+            {
+                flags_encountered = true;
+                arg_survey = true;
+            }
+            else if (strcmp(arg,"--merge") == 0)
+            {
+                flags_encountered = true;
+                arg_merge = true;
+            }
+            else if (strcmp(arg,"--work-dir") == 0)
+            {
+                flags_encountered = true;
+                i++;
                 if (i >= argc)
                 {
-                    fputs("Count threshold (-c | --count) must be followed by a number 1 or higher. See --help for board state formatting."
-                            " Usage: [-c <threshold>]\n", stderr);
+                    fputs("Work directory (--work-dir) must be followed by a directory. Usage: [--work-dir <dir>]\n", stderr);
                     exit(1);
                 }
-                if(arg_target_bits)
+                arg_work_dir = argv[i];
+            }
+            else if (strcmp(arg,"--time-limit") == 0 || strcmp(arg,"--level") == 0 || strcmp(arg,"--width") == 0
+                     || strcmp(arg,"--cache-mb") == 0 || strcmp(arg,"--split-depth") == 0 || strcmp(arg,"--shards") == 0
+                     || strcmp(arg,"-p") == 0 || strcmp(arg,"--processes") == 0
+                     || strcmp(arg,"--tablebase") == 0 || strcmp(arg,"--reach") == 0)
+            {
+                flags_encountered = true;
+                i++;
+                if (i >= argc)
                 {
-                    // intentionally put duplicate flag check after parsing, to provide parsing problem feedback first.
-                    fputs("Cannot specify both a target board state (-t | --target) and a marble count threshold (-c | --count)!\n", stderr);
+                    fprintf(stderr, "%s must be followed by a number. See --help %s for its usage.\n", arg, arg);
                     exit(1);
                 }
+                int value = parse_int(argv[i]);
+                if (strcmp(arg,"--time-limit") == 0)
+                {
+                    if (value < 1)
+                    {
+                        fputs("Time limit must be at least 1 second.\n", stderr);
+                        exit(1);
+                    }
+                    arg_time_limit = value;
+                }
+                else if (strcmp(arg,"--level") == 0)
+                {
+                    if (value < 0)
+                    {
+                        fputs("Nesting level must be 0 or higher.\n", stderr);
+                        exit(1);
+                    }
+                    arg_nmcs_level = value;
+                }
+                else if (strcmp(arg,"-p") == 0 || strcmp(arg,"--processes") == 0)
+                {
+                    if (value < 0)
+                    {
+                        fputs("Number of threads must be 0 (automatic) or higher.\n", stderr);
+                        exit(1);
+                    }
+                    arg_processes = value;
+                }
+                else if (strcmp(arg,"--tablebase") == 0)
+                {
+                    if (value < 1 || value > MAX_BOARD_CT)
+                    {
+                        fprintf(stderr, "Tablebase marble count must be between 1 and %d.\n", MAX_BOARD_CT);
+                        exit(1);
+                    }
+                    arg_tablebase_ct = value;
+                }
+                else if (strcmp(arg,"--reach") == 0)
+                {
+                    if (value < 1 || value > TB_MAX_REACH)
+                    {
+                        fprintf(stderr, "Tablebase final count must be between 1 and %d.\n", TB_MAX_REACH);
+                        exit(1);
+                    }
+                    arg_reach = value;
+                }
+                else if (strcmp(arg,"--split-depth") == 0)
+                {
+                    if (value < 0)
+                    {
+                        fputs("Split depth must be 0 or higher.\n", stderr);
+                        exit(1);
+                    }
+                    arg_split_depth = value;
+                }
+                else if (strcmp(arg,"--shards") == 0)
+                {
+                    if (value < 1)
+                    {
+                        fputs("Shard count must be 1 or higher.\n", stderr);
+                        exit(1);
+                    }
+                    arg_shards = value;
+                }
+                else if (strcmp(arg,"--width") == 0)
+                {
+                    if (value < 1)
+                    {
+                        fputs("Beam width must be 1 or higher.\n", stderr);
+                        exit(1);
+                    }
+                    arg_beam_width = value;
+                }
+                else
+                {
+                    if (value < 1)
+                    {
+                        fputs("Cache size must be at least 1 megabyte.\n", stderr);
+                        exit(1);
+                    }
+                    arg_cache_mb = value;
+                }
             }
             else if (argstrlen >= 2 && arg[0] == '-' && arg[1] != '-')
             {
@@ -695,6 +4746,10 @@ int main(int argc, char **argv)
                             }
                             arg_parse_boardstate_hex = true;
                             break;
+                        case 'e':
+                            // exhaustive search flag
+                            exhaustive_search = true;
+                            break;
                         default:
                             // unknown flag
                             fprintf(stderr, "Unexpected flag encountered: \"%c\", in argument \"%s\"\n", arg[j], arg);
@@ -718,6 +4773,136 @@ int main(int argc, char **argv)
     }
 
 
+    // any of the modes below may allocate large tables
+    if(huge_pages != HUGE_PAGES_ON)
+        fprintf(stdout, "CLI argument: Huge pages: %s\n", huge_pages == HUGE_PAGES_OFF ? "off" : "prefault");
+    prefault_threads = processes_to_threads(arg_processes);
+    // (checked before the modes below, which exit without searching)
+    if(arg_profile_path)
+    {
+        if((search_engine != ENGINE_DFS && search_engine != ENGINE_IDA) || arg_split_depth >= 0 || arg_shard_count || arg_merge
+           || arg_interactive || arg_survey || arg_bench || arg_validate_path || arg_convert_from || arg_tablebase_ct)
+        {
+            fputs("Only a dfs or ida search can be profiled (--profile), not a split search or any other mode!\n", stderr);
+            exit(1);
+        }
+        fprintf(stdout, "CLI argument: Profile: \"%s\"\n", arg_profile_path);
+        profiling = true;
+    }
+
+    if(arg_convert_from)
+    {
+        // the format flags -d and -x apply to the text file, wherever they are given
+        unsigned long long count = arg_convert_to_binary
+            ? convert_to_binary(arg_convert_from, arg_convert_to, arg_sort, arg_parse_boardstate_decimal, arg_parse_boardstate_hex)
+            : convert_to_text(arg_convert_from, arg_convert_to, arg_parse_boardstate_decimal, arg_parse_boardstate_hex);
+        printf("Converted %llu board states from \"%s\" to \"%s\".\n", count, arg_convert_from, arg_convert_to);
+        return 0;
+    }
+
+    if(arg_tablebase_ct)
+    {
+        if(!arg_work_dir)
+        {
+            fputs("A tablebase needs a work directory! Usage: [--work-dir <dir>]\n", stderr);
+            exit(1);
+        }
+        if(arg_tablebase_ct > board_ct)
+        {
+            fprintf(stderr, "Tablebase marble count must be between 1 and %d (the board's holes).\n", board_ct);
+            exit(1);
+        }
+        build_tablebase(arg_work_dir, arg_tablebase_ct, arg_reach, processes_to_threads(arg_processes));
+        return 0;
+    }
+
+    states_map_t targets_map = { 0 };
+    int targets_minct = 0;
+    if(arg_targets_path)
+    {
+        if(arg_target_bits || arg_target_count)
+        {
+            fputs("Cannot specify a target set (--targets) together with -t | --target or -c | --count!\n", stderr);
+            exit(1);
+        }
+        if(search_engine != ENGINE_DFS || arg_split_depth >= 0 || arg_shard_count || arg_merge)
+        {
+            fputs("Only the dfs engine can search for a target set (--targets), and not in a split search!\n", stderr);
+            exit(1);
+        }
+        double loadstart = now_seconds();
+        targets_minct = load_target_set(arg_targets_path, &targets_map);
+        fprintf(stdout, "CLI argument: Target set: %llu states from \"%s\" (loaded in %.2f seconds)\n",
+                target_set_len, arg_targets_path, now_seconds() - loadstart);
+    }
+
+    if(arg_validate_path)
+    {
+        // the format flags -d and -x apply to a text chain file, as they do to the board states
+        unsigned long long invalid = validate_chains(arg_validate_path, arg_start_bits, arg_target_bits,
+                                                     arg_target_count ? arg_target_count : 1,
+                                                     arg_parse_boardstate_decimal, arg_parse_boardstate_hex,
+                                                     processes_to_threads(arg_processes));
+        return invalid ? 1 : 0;
+    }
+
+    // (a survey is timed as a whole, like a search)
+    if(arg_time_limit)
+    {
+        fprintf(stdout, "CLI argument: Time limit: %d second%s\n", arg_time_limit, arg_time_limit==1?"":"s");
+        search_deadline = now_seconds() + arg_time_limit;
+    }
+
+    if(arg_survey)
+    {
+        if(arg_start_bits || target_set || exhaustive_search || arg_split_depth >= 0 || arg_shard_count || arg_merge)
+        {
+            fputs("A survey (--survey) takes no starting state, and cannot be used with --targets, -e | --exhaustive or a split search!\n", stderr);
+            exit(1);
+        }
+        run_survey(arg_target_bits, arg_target_count ? arg_target_count : 1, processes_to_threads(arg_processes), arg_cache_mb);
+        return 0;
+    }
+
+    split_plan_t plan = { 0 };
+    if(arg_split_depth >= 0 || arg_shard_count || arg_merge)
+    {
+        if((arg_split_depth >= 0) + (arg_shard_count > 0) + arg_merge > 1)
+        {
+            fputs("Only one of --split-depth, --shard and --merge can be specified at a time!\n", stderr);
+            exit(1);
+        }
+        if(!arg_work_dir)
+        {
+            fputs("A split search needs a work directory! Usage: [--work-dir <dir>]\n", stderr);
+            exit(1);
+        }
+        if(arg_shard_count || arg_merge)
+        {
+            if(arg_start_bits || arg_target_bits || arg_target_count)
+            {
+                fputs("The starting state and solution condition of a shard come from its plan, and cannot be specified!\n", stderr);
+                exit(1);
+            }
+            read_split_plan(&plan, arg_work_dir);
+            arg_start_bits = plan.start_bits;
+            arg_target_bits = plan.target_bits;
+            arg_target_count = plan.target_count;
+        }
+        if(arg_shard_count && search_engine != ENGINE_DFS && search_engine != ENGINE_IDA)
+        {
+            fputs("Only the dfs and ida engines can solve a shard! See --help --shard\n", stderr);
+            exit(1);
+        }
+    }
+
+    if(arg_board_name || dirs_len > ORTHOGONAL_DIRS_LEN)
+    {
+        fprintf(stdout, "CLI argument: Board: %s (%d holes)%s", arg_board_name ? arg_board_name : "french", board_ct,
+                dirs_len > ORTHOGONAL_DIRS_LEN ? ", with diagonal jumps" : "");
+        printbits_square(board_holes);
+        fputs("\n", stdout);
+    }
     if(arg_start_bits)
     {
         fprintf(stdout, "CLI argument: Starting state: 0x %012llx (base 16)", arg_start_bits);
@@ -736,6 +4921,42 @@ int main(int argc, char **argv)
     {
         fprintf(stdout, "CLI argument: Marble threshold: %d\n", arg_target_count);
     }
+    if(search_engine != ENGINE_DFS)
+    {
+        if(arg_target_bits)
+        {
+            fputs("Only the dfs engine can search for a target board state (-t | --target)! See --help --engine\n", stderr);
+            exit(1);
+        }
+        fprintf(stdout, "CLI argument: Engine: %s", search_engine == ENGINE_NMCS ? "nmcs" : search_engine == ENGINE_BEAM ? "beam" : "ida");
+        if(search_engine == ENGINE_NMCS) fprintf(stdout, " (level %d)\n", arg_nmcs_level);
+        else if(search_engine == ENGINE_BEAM) fprintf(stdout, " (width %d)\n", arg_beam_width);
+        else fprintf(stdout, " (cache %d MB)\n", arg_cache_mb);
+    }
+    if(exhaustive_search)
+    {
+        if(search_engine != ENGINE_DFS || arg_split_depth >= 0 || arg_shard_count || arg_merge || arg_interactive)
+        {
+            fputs("Only the dfs engine can search exhaustively (-e | --exhaustive), and not in a split search!\n", stderr);
+            exit(1);
+        }
+        fputs("CLI argument: Exhaustive search\n", stdout);
+    }
+
+    if(arg_interactive)
+    {
+        if(arg_target_bits || target_set || arg_split_depth >= 0 || arg_shard_count || arg_merge)
+        {
+            fputs("Interactive play (-i | --interactive) cannot be used with -t | --target, --targets or a split search!\n", stderr);
+            exit(1);
+        }
+        init_symmetry();
+        init_class_bound();
+        cache_init(&vcache, arg_cache_mb);
+        run_interactive(arg_start_bits, arg_parse_boardstate_decimal, arg_parse_boardstate_hex,
+                        arg_time_limit, processes_to_threads(arg_processes));
+        return 0;
+    }
 
     // return 0;
 
@@ -743,6 +4964,12 @@ int main(int argc, char **argv)
     // curindex = 0;
     sarr = (state_t*) malloc(sizeof *sarr * STATES_ARR_LEN);
 
+    if(arg_bench)
+    {
+        run_benchmarks(arg_cache_mb);
+        return 0;
+    }
+
     /*
     // methods testing
     {
@@ -878,96 +5105,88 @@ int main(int argc, char **argv)
 
     const int targetct = arg_target_bits
                          ? count_bits(arg_target_bits)
+                         : target_set
+                         ? targets_minct
                          : arg_target_count
                          ? arg_target_count
                          : 1;
 
-    int bestct = sarr[sarrlen-1].ct;//FULL_BOARD_CT;
-    int largestsarrlen = 0;
-    int curindex;
-    int newgen;
+    if (arg_split_depth >= 0)
+    {
+        plan = (split_plan_t){
+            .start_bits = arg_start_bits,
+            .target_bits = arg_target_bits,
+            .target_count = arg_target_count,
+            .depth = arg_split_depth,
+            .shards = arg_shards
+        };
+        long states = write_split_plan(&plan, arg_work_dir);
+        printf("Split %ld states into %d shard%s in \"%s\".\n", states, plan.shards, plan.shards==1?"":"s", arg_work_dir);
+        return 0;
+    }
+
+    int bestct;
     unsigned long long checked = 0;
     unsigned long long generated = 0;
-    // while (sarrlen > 0 && bestct > targetct)
-    while (sarrlen > 0 && bestct > targetct)
+    if (arg_merge)
+        bestct = merge_shard_results(&plan, arg_work_dir, &checked, &generated);
+    else if (arg_shard_count)
     {
-        if (sarrlen > largestsarrlen) largestsarrlen = sarrlen;
-        // generate the next moves. returns how many moves were generated and added to the list.
-        newgen = add_all_moves_latest();
-        if (newgen > 0)
-            generated += newgen;
-        if (newgen == 0 && checked > 0)
-            // if newgen == 0, then it was a leaf node.
-            // If no states have been checked yet then we should still check this leaf node, as it must NOT have been generated.
-            // Otherwise leaves can be ignored and removed, because they would have been checked when first generated.
-            continue;
-        // Note: even if newgen < 0, meaning a previsited node was removed,
-        // that means a node was uncovered on the list that can be checked.
-        // the uncovered node could still be visited, hence the curstate.visited check below.
-
-        // inspect, or check, the latest board state.
-        curindex = sarrlen - 1;
-        state_t curstate = sarr[curindex];
-        if (curstate.visited)
-        {
-            // no need to check a visited node. It would have been checked already.
-            // (assuming the state array did not start polluted with a state with .visited==true)
-            continue;
-        }
-        checked++; // the node being checked should be an entirely unseen node at this point.
-        
-        // check if the newly generated board state is a specific state we are looking for.
-        if (arg_target_bits)
-        {
-            // Note: this is separated from bestct logic to prevent the bestct > targetct condition stopping the while-loop.
-            
-            if (arg_target_bits == curstate.bits)
-            {
-                printf("Found a target state with %d marbles remaining (state base16: 0x %012llx).\n", curstate.ct, curstate.bits);
-                save_parent_chain(curindex);
-                bestct = targetct;
-            }
-            // PRUNE depth first search by easy marble count guarantee
-            else if (curstate.ct <= targetct)
-            {
-                // curstate is not the solution,
-                // and also is easily guaranteed to never produce the solution later.
-                //   (by its marble count not being higher)
-                // Therefore, mark it for "removal".
-                // This prunes the searching needed to be performed.
-                curstate.visited = true;
-                sarr[curindex] = curstate; // put changes back into state array.
-            }
-        }
-        // check if the newly generated board state is better than our best so far.
-        // (only if we are not looking for a specific board state)
-        else
-        if (curstate.ct < bestct)
-        {
-            bestct = curstate.ct;
-            printf("Found new best state with %d marbles remaining (base16: 0x %012llx).\n", bestct, curstate.bits);
-            // save chain of solutions
-            save_parent_chain(curindex);
-        }
-
-        #ifdef PRINT_STATS_EVERY_CHECKED
-        if(checked % PRINT_STATS_EVERY_CHECKED_N == 0)
-            printf("...info: Checked %llu states, Generated %llu states; best %d, max sarrlen %d of %d...\n",
-                checked, generated, bestct, largestsarrlen, STATES_ARR_LEN);
-        #endif
+        if (search_engine == ENGINE_IDA)
+            cache_init(&vcache, arg_cache_mb);
+        bestct = solve_shard(&plan, arg_work_dir, arg_shard_index, arg_shard_count, targetct, &checked, &generated);
     }
+    else if (search_engine == ENGINE_NMCS)
+        bestct = solve_nmcs(arg_start_bits, targetct, arg_nmcs_level, &checked, &generated);
+    else if (search_engine == ENGINE_BEAM)
+        bestct = solve_beam(arg_start_bits, targetct, arg_beam_width, &checked, &generated);
+    else if (search_engine == ENGINE_IDA)
+    {
+        init_symmetry();
+        init_class_bound();
+        cache_init(&vcache, arg_cache_mb);
+        if (profiling)
+            profile_start();
+        bestct = solve_ida(arg_start_bits, targetct, &checked, &generated);
+    }
+    else
+    {
+        if (profiling)
+            profile_start();
+        bestct = solve_dfs(arg_target_bits, targetct, &checked, &generated);
+    }
+    if (profiling)
+        write_profile(arg_profile_path, count_bits(arg_start_bits));
 
-    if (sarrlen <= 0)
+    if (__atomic_load_n(&timed_out, __ATOMIC_RELAXED))
+        printf("Time limit of %d second%s reached; reporting the best found so far.\n", arg_time_limit, arg_time_limit==1?"":"s");
+
+    bool target_found = solarr && solarrlen > 0 && is_target_state(arg_target_bits, solarr[solarrlen-1].bits);
+    if (exhaustive_search)
+        printf("Exhaustive search %s: %llu solution%s found.\n", __atomic_load_n(&timed_out, __ATOMIC_RELAXED) ? "stopped early" : "finished",
+               solutions_found, solutions_found==1?"":"s");
+    if (sarrlen <= 0 && !solutions_found)
     {
         if(arg_target_bits)
             printf("Exhausted all child states; could not find the custom target state.\n");
+        else if(target_set)
+            printf("Exhausted all child states; could not find any state of the target set.\n");
         else
             printf("Exhausted all child states; could not find a solution with %d marble%s.\n", targetct, targetct==1?"":"s or less");
     }
 
-    if (arg_target_bits)
+    if (target_set)
+    {
+        if (target_found)
+            printf("Found the target set state 0x %012llx (base16) starting from 0x %012llx (base16)!\n",
+                   solarr[solarrlen-1].bits, arg_start_bits);
+        else
+            printf("Could not find any of the %llu target set states starting from 0x %012llx (base16).\n",
+                   target_set_len, arg_start_bits);
+    }
+    else if (arg_target_bits)
     {
-        if (solarr && solarrlen > 0 && arg_target_bits == solarr[solarrlen-1].bits) {
+        if (target_found) {
             // arg_target_bits was specified _and_ was found
             printf("Found the the custom target state 0x %012llx (base16) starting from 0x %012llx (base16)!\n",
                    arg_target_bits, arg_start_bits);
@@ -987,7 +5206,7 @@ int main(int argc, char **argv)
         if(arg_target_count) printf("  (Note: custom threshold of %d was specified.)\n", arg_target_count);
     }
     
-    if(!(arg_start_bits && (solarr && solarrlen > 0 && arg_target_bits == solarr[solarrlen-1].bits)))
+    if(!(arg_target_bits || target_set) || target_found)
         // if either:
         //   solving by threshold (no specific target state was specified), or
         //   the specific target state was found
@@ -996,6 +5215,7 @@ int main(int argc, char **argv)
     fprintf(stdout, "Info: Checked %llu states. Generated %llu states. Found a best with %d remaining", checked, generated, bestct);
     if(arg_target_count) fprintf(stdout, " (custom threshold of %d)", arg_target_count);
     if(arg_target_bits) fprintf(stdout, " (custom target state of 0x %012llx in base16)", arg_target_bits);
+    if(target_set) fprintf(stdout, " (target set of %llu states)", target_set_len);
     fputs(".\n", stdout);
 
     //